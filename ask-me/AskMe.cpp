@@ -4,19 +4,591 @@
 #include <string>
 #include <vector>
 #include <unordered_map>
+#include <unordered_set>
+#include <set>
 #include <algorithm>
 #include <stdexcept>
 #include <iomanip>
 #include <cassert>
 #include <filesystem>
+#include <string_view>
+#include <charconv>
+#include <deque>
+#include <cstdint>
+#include <chrono>
+#include <limits>
+#include <shared_mutex>
+#include <mutex>
+#include <thread>
+#include <atomic>
+#include <list>
+#include <csignal>
+#include <cstring>
+#include <random>
+#include <cmath>
+#include <numeric>
+#include <exception>
+#include <map>
+#include <memory>
+
+#if defined(__unix__) || defined(__APPLE__)
+#define ASKME_HAS_SERVER 1
+#include <sys/socket.h>
+#include <netinet/in.h>
+#include <arpa/inet.h>
+#include <poll.h>
+#include <unistd.h>
+#include <cerrno>
+#endif
 
 using namespace std;
 
+class BinaryWriter;
+class BinaryReader;
 class User;
 class Question;
 class FileManager;
+class DataStore;
 class UserManager;
 
+// Opt-in hot-path instrumentation: build with -DASKME_TRACE to enable
+// Timers and counters live in a registry keyed by name; each call site looks its
+// metric up once, then updates it with relaxed atomics. Trace::PrintSummary() reports them all.
+// Without ASKME_TRACE the macros expand to nothing, arguments included.
+#ifdef ASKME_TRACE
+class Trace {
+public:
+    // One named timer (amounts in nanoseconds) or counter (amounts in its own unit)
+    class Metric {
+    public:
+        const string name;
+        const bool is_timer;
+        atomic<uint64_t> events{0};
+        atomic<uint64_t> total{0};
+        atomic<uint64_t> largest{0};
+
+        Metric(const string& name, bool is_timer) : name(name), is_timer(is_timer) {}
+
+        void Add(uint64_t amount) {
+            events.fetch_add(1, memory_order_relaxed);
+            total.fetch_add(amount, memory_order_relaxed);
+            uint64_t seen = largest.load(memory_order_relaxed);
+            while (amount > seen && !largest.compare_exchange_weak(seen, amount, memory_order_relaxed)) {
+            }
+        }
+    };
+
+    // Times the enclosing block into a timer metric
+    class Scope {
+    private:
+        Metric& metric;
+        chrono::steady_clock::time_point start;
+
+    public:
+        explicit Scope(Metric& metric) : metric(metric), start(chrono::steady_clock::now()) {}
+
+        ~Scope() {
+            metric.Add(chrono::duration_cast<chrono::nanoseconds>(chrono::steady_clock::now() - start).count());
+        }
+    };
+
+    // Returns the metric called `name`, creating it on first use
+    // Call sites sharing a name share one metric; each site caches the reference
+    static Metric& Get(const char* name, bool is_timer) {
+        lock_guard<std::mutex> lock(RegistryMutex());
+        unique_ptr<Metric>& metric = Registry()[name];
+        if (!metric) {
+            metric = make_unique<Metric>(name, is_timer);
+        }
+        return *metric;
+    }
+
+    // Prints every metric that has fired, timers first, each group sorted by name
+    static void PrintSummary(ostream& out) {
+        vector<Metric*> metrics;
+        {
+            lock_guard<std::mutex> lock(RegistryMutex());
+            for (const auto& [name, metric] : Registry()) {
+                metrics.push_back(metric.get());
+            }
+        }
+        // The registry is ordered by name, so a stable sort keeps each group alphabetical
+        stable_sort(metrics.begin(), metrics.end(), [](const Metric* a, const Metric* b) {
+            return a->is_timer && !b->is_timer;
+        });
+
+        out << "\n─── Trace Summary ───\n";
+        out << left << setw(40) << "Timer" << right << setw(10) << "Calls" << setw(14) << "Total ms"
+            << setw(12) << "Mean us" << setw(12) << "Max us" << "\n";
+        bool counters_started = false;
+        for (const Metric* metric : metrics) {
+            uint64_t events = metric->events.load(memory_order_relaxed);
+            if (events == 0) {
+                continue;
+            }
+            uint64_t total = metric->total.load(memory_order_relaxed);
+            uint64_t largest = metric->largest.load(memory_order_relaxed);
+            if (metric->is_timer) {
+                out << left << setw(40) << metric->name << right << setw(10) << events << fixed << setprecision(3)
+                    << setw(14) << total / 1e6 << setw(12) << total / 1e3 / events << setw(12) << largest / 1e3 << "\n";
+                continue;
+            }
+            if (!counters_started) {
+                out << left << setw(40) << "Counter" << right << setw(10) << "Events" << setw(14) << "Total"
+                    << setw(12) << "Mean" << setw(12) << "Max" << "\n";
+                counters_started = true;
+            }
+            out << left << setw(40) << metric->name << right << setw(10) << events << setw(14) << total
+                << fixed << setprecision(1) << setw(12) << double(total) / events << setw(12) << largest << "\n";
+        }
+        out.unsetf(ios::floatfield);
+    }
+
+private:
+    static map<string, unique_ptr<Metric>>& Registry() {
+        static map<string, unique_ptr<Metric>> metrics;
+        return metrics;
+    }
+
+    static std::mutex& RegistryMutex() {
+        static std::mutex registry_mutex;
+        return registry_mutex;
+    }
+};
+
+#define ASKME_TRACE_JOIN2(a, b) a##b
+#define ASKME_TRACE_JOIN(a, b) ASKME_TRACE_JOIN2(a, b)
+// Times the rest of the enclosing block under `name` (a string literal)
+#define ASKME_TRACE_SCOPE(name) \
+    static Trace::Metric& ASKME_TRACE_JOIN(trace_metric_, __LINE__) = Trace::Get(name, true); \
+    Trace::Scope ASKME_TRACE_JOIN(trace_scope_, __LINE__)(ASKME_TRACE_JOIN(trace_metric_, __LINE__))
+// Adds `amount` to the counter `name` (a string literal)
+#define ASKME_TRACE_COUNT(name, amount) \
+    do { \
+        static Trace::Metric& trace_counter = Trace::Get(name, false); \
+        trace_counter.Add(static_cast<uint64_t>(amount)); \
+    } while (0)
+#else
+#define ASKME_TRACE_SCOPE(name) ((void)0)
+#define ASKME_TRACE_COUNT(name, amount) ((void)0)
+#endif
+
+// Builds a binary data file in memory
+// Integers are fixed-width little-endian, strings are length-prefixed
+class BinaryWriter {
+private:
+    string buffer; // Encoded bytes
+
+public:
+    // Appends a single byte
+    void WriteU8(uint8_t value) {
+        buffer += static_cast<char>(value);
+    }
+
+    // Appends a 4-byte unsigned integer
+    void WriteU32(uint32_t value) {
+        for (int shift = 0; shift < 32; shift += 8) {
+            buffer += static_cast<char>((value >> shift) & 0xFF);
+        }
+    }
+
+    // Appends a 4-byte signed integer
+    void WriteInt(int value) {
+        WriteU32(static_cast<uint32_t>(value));
+    }
+
+    // Appends a string as its length followed by its bytes
+    void WriteString(const string& value) {
+        WriteU32(static_cast<uint32_t>(value.size()));
+        buffer += value;
+    }
+
+    // Gets everything written so far
+    const string& Buffer() const { return buffer; }
+
+    // Computes the FNV-1a checksum used to validate binary files
+    static uint32_t Checksum(string_view data) {
+        uint32_t hash = 2166136261u;
+        for (unsigned char c : data) {
+            hash = (hash ^ c) * 16777619u;
+        }
+        return hash;
+    }
+};
+
+// Decodes data written by BinaryWriter
+// Reads past the end don't throw; they mark the reader as failed instead
+class BinaryReader {
+private:
+    string_view data;   // Bytes being decoded
+    size_t position = 0; // Offset of the next unread byte
+    bool ok = true;     // False once a read ran past the end
+
+    // Reserves `size` bytes for reading
+    // Returns: False (and marks the reader failed) if not enough bytes are left
+    bool Take(size_t size) {
+        if (!ok || data.size() - position < size) {
+            ok = false;
+            return false;
+        }
+        return true;
+    }
+
+public:
+    BinaryReader(string_view data) : data(data) {}
+
+    // Reads a single byte (0 on failure)
+    uint8_t ReadU8() {
+        if (!Take(1)) return 0;
+        return static_cast<uint8_t>(data[position++]);
+    }
+
+    // Reads a 4-byte unsigned integer (0 on failure)
+    uint32_t ReadU32() {
+        if (!Take(4)) return 0;
+        uint32_t value = 0;
+        for (int shift = 0; shift < 32; shift += 8) {
+            value |= static_cast<uint32_t>(static_cast<unsigned char>(data[position++])) << shift;
+        }
+        return value;
+    }
+
+    // Reads a 4-byte signed integer (0 on failure)
+    int ReadInt() {
+        return static_cast<int>(ReadU32());
+    }
+
+    // Reads a length-prefixed string (empty on failure)
+    string ReadString() {
+        uint32_t size = ReadU32();
+        if (!Take(size)) return "";
+        string value(data.substr(position, size));
+        position += size;
+        return value;
+    }
+
+    // Gets the bytes that haven't been read yet
+    string_view Remaining() const { return data.substr(position); }
+
+    // Checks that every read so far stayed inside the data
+    bool Ok() const { return ok; }
+};
+
+// Formats text into a reusable buffer and writes it to a stream in large chunks
+// Used for long listings (feeds, inboxes) instead of many small `cout <<` calls
+class OutputBuffer {
+private:
+    ostream& out;       // Destination stream
+    string buffer;      // Text that hasn't been written yet
+    size_t chunk_size;  // Buffered size that triggers a write
+
+public:
+    OutputBuffer(ostream& out = cout, size_t chunk_size = 64 * 1024) : out(out), chunk_size(chunk_size) {
+        buffer.reserve(chunk_size + 1024);
+    }
+
+    // Writes whatever is still buffered
+    ~OutputBuffer() {
+        Flush();
+    }
+
+    OutputBuffer(const OutputBuffer&) = delete;
+    OutputBuffer& operator=(const OutputBuffer&) = delete;
+
+    OutputBuffer& operator<<(string_view text) {
+        buffer.append(text);
+        return FlushIfFull();
+    }
+
+    OutputBuffer& operator<<(char c) {
+        buffer += c;
+        return FlushIfFull();
+    }
+
+    // Formats integers in place, without to_string temporaries
+    OutputBuffer& operator<<(long long value) {
+        char digits[24];
+        auto result = to_chars(digits, digits + sizeof(digits), value);
+        buffer.append(digits, result.ptr);
+        return FlushIfFull();
+    }
+
+    OutputBuffer& operator<<(int value) {
+        return *this << static_cast<long long>(value);
+    }
+
+    OutputBuffer& operator<<(size_t value) {
+        return *this << static_cast<long long>(value);
+    }
+
+    // Writes the buffered text to the stream in one call
+    void Flush() {
+        if (!buffer.empty()) {
+            out.write(buffer.data(), buffer.size());
+            buffer.clear();
+        }
+    }
+
+private:
+    OutputBuffer& FlushIfFull() {
+        if (buffer.size() >= chunk_size) {
+            Flush();
+        }
+        return *this;
+    }
+};
+
+// Salted password hashing for the users file (PBKDF2-HMAC-SHA256)
+// Stored format: pbkdf2-sha256$<iterations>$<salt hex>$<hash hex>
+// Anything without that prefix is a legacy plaintext password, upgraded on the next login
+class PasswordHasher {
+public:
+    static constexpr int DEFAULT_ITERATIONS = 10000; // Work factor for new hashes
+    static constexpr int MAX_ITERATIONS = 1000000;   // Stored hashes asking for more are rejected, so a
+                                                     // crafted users file can't stall a login
+
+private:
+    static constexpr string_view PREFIX = "pbkdf2-sha256$";
+    static constexpr size_t SALT_SIZE = 16;
+    static inline atomic<int> iterations{DEFAULT_ITERATIONS};
+
+    // Incremental SHA-256 (FIPS 180-4)
+    class Sha256 {
+    private:
+        uint32_t state[8] = {0x6a09e667, 0xbb67ae85, 0x3c6ef372, 0xa54ff53a,
+                             0x510e527f, 0x9b05688c, 0x1f83d9ab, 0x5be0cd19};
+        unsigned char block[64];
+        size_t used = 0;        // Bytes waiting in `block`
+        uint64_t length = 0;    // Total bytes hashed
+
+        static uint32_t Rotate(uint32_t x, int n) { return (x >> n) | (x << (32 - n)); }
+
+        void Compress() {
+            static const uint32_t K[64] = {
+                0x428a2f98, 0x71374491, 0xb5c0fbcf, 0xe9b5dba5, 0x3956c25b, 0x59f111f1, 0x923f82a4, 0xab1c5ed5,
+                0xd807aa98, 0x12835b01, 0x243185be, 0x550c7dc3, 0x72be5d74, 0x80deb1fe, 0x9bdc06a7, 0xc19bf174,
+                0xe49b69c1, 0xefbe4786, 0x0fc19dc6, 0x240ca1cc, 0x2de92c6f, 0x4a7484aa, 0x5cb0a9dc, 0x76f988da,
+                0x983e5152, 0xa831c66d, 0xb00327c8, 0xbf597fc7, 0xc6e00bf3, 0xd5a79147, 0x06ca6351, 0x14292967,
+                0x27b70a85, 0x2e1b2138, 0x4d2c6dfc, 0x53380d13, 0x650a7354, 0x766a0abb, 0x81c2c92e, 0x92722c85,
+                0xa2bfe8a1, 0xa81a664b, 0xc24b8b70, 0xc76c51a3, 0xd192e819, 0xd6990624, 0xf40e3585, 0x106aa070,
+                0x19a4c116, 0x1e376c08, 0x2748774c, 0x34b0bcb5, 0x391c0cb3, 0x4ed8aa4a, 0x5b9cca4f, 0x682e6ff3,
+                0x748f82ee, 0x78a5636f, 0x84c87814, 0x8cc70208, 0x90befffa, 0xa4506ceb, 0xbef9a3f7, 0xc67178f2};
+            uint32_t w[64];
+            for (int i = 0; i < 16; ++i) {
+                w[i] = uint32_t(block[4 * i]) << 24 | uint32_t(block[4 * i + 1]) << 16 |
+                       uint32_t(block[4 * i + 2]) << 8 | uint32_t(block[4 * i + 3]);
+            }
+            for (int i = 16; i < 64; ++i) {
+                uint32_t s0 = Rotate(w[i - 15], 7) ^ Rotate(w[i - 15], 18) ^ (w[i - 15] >> 3);
+                uint32_t s1 = Rotate(w[i - 2], 17) ^ Rotate(w[i - 2], 19) ^ (w[i - 2] >> 10);
+                w[i] = w[i - 16] + s0 + w[i - 7] + s1;
+            }
+            uint32_t a = state[0], b = state[1], c = state[2], d = state[3];
+            uint32_t e = state[4], f = state[5], g = state[6], h = state[7];
+            for (int i = 0; i < 64; ++i) {
+                uint32_t t1 = h + (Rotate(e, 6) ^ Rotate(e, 11) ^ Rotate(e, 25)) + ((e & f) ^ (~e & g)) + K[i] + w[i];
+                uint32_t t2 = (Rotate(a, 2) ^ Rotate(a, 13) ^ Rotate(a, 22)) + ((a & b) ^ (a & c) ^ (b & c));
+                h = g; g = f; f = e; e = d + t1;
+                d = c; c = b; b = a; a = t1 + t2;
+            }
+            state[0] += a; state[1] += b; state[2] += c; state[3] += d;
+            state[4] += e; state[5] += f; state[6] += g; state[7] += h;
+        }
+
+    public:
+        void Update(string_view data) {
+            length += data.size();
+            while (!data.empty()) {
+                size_t take = min(data.size(), sizeof(block) - used);
+                memcpy(block + used, data.data(), take);
+                used += take;
+                data.remove_prefix(take);
+                if (used == sizeof(block)) {
+                    Compress();
+                    used = 0;
+                }
+            }
+        }
+
+        // Returns: The 32-byte digest (the object is spent afterwards)
+        string Final() {
+            uint64_t bits = length * 8;
+            block[used++] = 0x80;
+            if (used > 56) {
+                memset(block + used, 0, sizeof(block) - used);
+                Compress();
+                used = 0;
+            }
+            memset(block + used, 0, 56 - used);
+            used = 56;
+            for (int i = 7; i >= 0; --i) {
+                block[used++] = static_cast<unsigned char>(bits >> (8 * i));
+            }
+            Compress();
+            string digest(32, '\0');
+            for (int i = 0; i < 32; ++i) {
+                digest[i] = static_cast<char>(state[i / 4] >> (24 - 8 * (i % 4)));
+            }
+            return digest;
+        }
+    };
+
+    // HMAC-SHA256 with the padded key already absorbed, so each message costs two compressions
+    class Hmac {
+    private:
+        Sha256 inner, outer;
+
+    public:
+        explicit Hmac(string_view key) {
+            string padded_key = key.size() > 64 ? Sha256Digest(key) : string(key);
+            padded_key.resize(64, '\0');
+            string inner_pad(64, '\0'), outer_pad(64, '\0');
+            for (int i = 0; i < 64; ++i) {
+                inner_pad[i] = static_cast<char>(padded_key[i] ^ 0x36);
+                outer_pad[i] = static_cast<char>(padded_key[i] ^ 0x5c);
+            }
+            inner.Update(inner_pad);
+            outer.Update(outer_pad);
+        }
+
+        string Sign(string_view message) const {
+            Sha256 in = inner, out = outer;
+            in.Update(message);
+            out.Update(in.Final());
+            return out.Final();
+        }
+    };
+
+    static string Sha256Digest(string_view data) {
+        Sha256 sha;
+        sha.Update(data);
+        return sha.Final();
+    }
+
+    // Derives a 32-byte key (PBKDF2, RFC 8018, single block)
+    static string Pbkdf2(string_view password, string_view salt, int rounds) {
+        const Hmac hmac(password);
+        string u = hmac.Sign(string(salt) + string("\0\0\0\x01", 4));
+        string result = u;
+        for (int i = 1; i < rounds; ++i) {
+            u = hmac.Sign(u);
+            for (size_t j = 0; j < result.size(); ++j) {
+                result[j] ^= u[j];
+            }
+        }
+        return result;
+    }
+
+    static string ToHex(string_view bytes) {
+        static const char digits[] = "0123456789abcdef";
+        string hex;
+        hex.reserve(bytes.size() * 2);
+        for (unsigned char byte : bytes) {
+            hex += digits[byte >> 4];
+            hex += digits[byte & 0x0f];
+        }
+        return hex;
+    }
+
+    static bool FromHex(string_view hex, string& bytes) {
+        if (hex.size() % 2 != 0) {
+            return false;
+        }
+        bytes.clear();
+        for (size_t i = 0; i < hex.size(); i += 2) {
+            unsigned value;
+            auto [end, error] = from_chars(hex.data() + i, hex.data() + i + 2, value, 16);
+            if (error != errc() || end != hex.data() + i + 2) {
+                return false;
+            }
+            bytes += static_cast<char>(value);
+        }
+        return true;
+    }
+
+    // Splits a stored hash into its parts
+    // Returns: False for legacy plaintext or malformed hashes
+    static bool Parse(string_view stored, int& rounds, string& salt, string& hash) {
+        if (stored.substr(0, PREFIX.size()) != PREFIX) {
+            return false;
+        }
+        stored.remove_prefix(PREFIX.size());
+        size_t first = stored.find('$'), second = stored.find('$', first + 1);
+        if (first == string_view::npos || second == string_view::npos) {
+            return false;
+        }
+        auto [end, error] = from_chars(stored.data(), stored.data() + first, rounds);
+        return error == errc() && end == stored.data() + first && rounds > 0 && rounds <= MAX_ITERATIONS &&
+               FromHex(stored.substr(first + 1, second - first - 1), salt) &&
+               FromHex(stored.substr(second + 1), hash) && hash.size() == 32;
+    }
+
+public:
+    // Compares without an early exit, so timing doesn't reveal how much matched
+    static bool ConstantTimeEquals(string_view a, string_view b) {
+        unsigned char difference = a.size() == b.size() ? 0 : 1;
+        for (size_t i = 0; i < a.size(); ++i) {
+            difference |= static_cast<unsigned char>(a[i] ^ (i < b.size() ? b[i] : 0));
+        }
+        return difference == 0;
+    }
+
+    // Returns: `size` bytes from the system's random source
+    static string RandomBytes(size_t size) {
+        random_device source;
+        string bytes(size, '\0');
+        for (char& byte : bytes) {
+            byte = static_cast<char>(source());
+        }
+        return bytes;
+    }
+
+    // Fast keyed fingerprint (HMAC-SHA256) for caching verified credentials in memory
+    static string Fingerprint(string_view key, string_view message) {
+        return Hmac(key).Sign(message);
+    }
+
+    // Hashes a password with a fresh salt
+    // rounds: Work factor (0 = current setting)
+    static string Hash(string_view password, int rounds = 0) {
+        rounds = rounds > 0 ? rounds : GetIterations();
+        string salt = RandomBytes(SALT_SIZE);
+        return string(PREFIX) + to_string(rounds) + "$" + ToHex(salt) + "$" + ToHex(Pbkdf2(password, salt, rounds));
+    }
+
+    // Checks a password against a stored hash (or a legacy plaintext password)
+    static bool Verify(string_view password, string_view stored) {
+        int rounds;
+        string salt, hash;
+        if (!Parse(stored, rounds, salt, hash)) {
+            return !IsHashed(stored) && ConstantTimeEquals(password, stored);
+        }
+        return ConstantTimeEquals(Pbkdf2(password, salt, rounds), hash);
+    }
+
+    // Checks whether a stored password is in the hashed format
+    static bool IsHashed(string_view stored) {
+        return stored.substr(0, PREFIX.size()) == PREFIX;
+    }
+
+    // Checks whether a stored password should be re-hashed at the current work factor
+    static bool NeedsRehash(string_view stored) {
+        int rounds;
+        string salt, hash;
+        return !Parse(stored, rounds, salt, hash) || rounds < GetIterations();
+    }
+
+    // Sets the work factor (PBKDF2 iterations) for new hashes
+    static void SetIterations(int rounds) {
+        iterations = clamp(rounds, 1, MAX_ITERATIONS);
+    }
+
+    // Gets the work factor for new hashes
+    static int GetIterations() {
+        return iterations;
+    }
+};
+
 // Represents a user account in the system with authentication capabilities
 // Handles user data, permissions, and serialization to strings
 class User {
@@ -31,7 +603,7 @@ private:
     // User data members
     int id;                     // Unique numeric identifier
     string name;                // Full display name
-    string password;            // Authentication secret (stored in plaintext)
+    string password;            // Salted password hash (see PasswordHasher; legacy files hold plaintext)
     string username;            // Login identifier
     string email;               // Contact address
     bool allow_anonymous_questions;  // Permission flag for anonymous questions
@@ -42,10 +614,10 @@ public:
     User() : id(0), allow_anonymous_questions(false), role(REGULAR_USER) {}
     
     // Creates a fully specified user account
-    // Note: Password stored in plaintext - So I'll consider hashing in real applications
-    User(int id, const string& name, const string& password, const string& username,
-        const string& email, bool allow_anonymous_questions, Role role = REGULAR_USER)
-        : id(id), name(name), password(password), username(username), email(email),
+    // password: The stored credential as read from the users file - use setPassword() for a new plaintext one
+    User(int id, string name, string password, string username,
+        string email, bool allow_anonymous_questions, Role role = REGULAR_USER)
+        : id(id), name(move(name)), password(move(password)), username(move(username)), email(move(email)),
         allow_anonymous_questions(allow_anonymous_questions), role(role) {}
 
 
@@ -70,19 +642,53 @@ public:
     // Changes whether user accepts anonymous questions
     void setAllowAnonymousQuestions(bool allow) { allow_anonymous_questions = allow; }
 
+    // Gets the stored credential (a password hash, or legacy plaintext)
+    const string& getPasswordHash() const { return password; }
+
+    // Replaces the password, storing only its salted hash
+    void setPassword(string_view plaintext) { password = PasswordHasher::Hash(plaintext); }
+
+    // Replaces the stored credential with an already computed hash
+    void setPasswordHash(string hash) { password = move(hash); }
+
     // Verifies if a password matches the user's stored password
     // inputPassword: The plaintext password to check
-    // Returns: True if passwords match (case-sensitive comparison)
+    // Returns: True if passwords match (constant-time comparison)
     bool verifyPassword(const string& inputPassword) const {
-        return password == inputPassword;
+        return PasswordHasher::Verify(inputPassword, password);
     }
     
     // Converts user data to a CSV-formatted string
-    // Format: "id,name,password,username,email,anonymous_flag"
+    // Format: "id,name,password_hash,username,email,anonymous_flag"
     string toString() const {
         return to_string(id) + "," + name + "," + password + "," + username + ","
         + email + "," + (allow_anonymous_questions ? "1" : "0") + "," + to_string(role);
     }
+
+    // Writes user data in the binary snapshot format
+    // Layout: id, name, password, username, email, anonymous_flag, role
+    void writeBinary(BinaryWriter& out) const {
+        out.WriteInt(id);
+        out.WriteString(name);
+        out.WriteString(password);
+        out.WriteString(username);
+        out.WriteString(email);
+        out.WriteU8(allow_anonymous_questions ? 1 : 0);
+        out.WriteU8(role == ADMIN ? 0 : 1);
+    }
+
+    // Reads a user written by writeBinary
+    // Note: Check in.Ok() afterwards to detect truncated data
+    static User readBinary(BinaryReader& in) {
+        int id = in.ReadInt();
+        string name = in.ReadString();
+        string password = in.ReadString();
+        string username = in.ReadString();
+        string email = in.ReadString();
+        bool allow_anonymous = in.ReadU8() == 1;
+        Role role = in.ReadU8() == 0 ? ADMIN : REGULAR_USER;
+        return User(id, move(name), move(password), move(username), move(email), allow_anonymous, role);
+    }
 };
 
 // Represents a question/answer pair between users
@@ -108,10 +714,10 @@ public:
     // is_anonymous: Hides the sender's identity when true
     // answer: Can pre-populate an answer (default empty)
     Question(int id, int parent_id, int from_user_id, int to_user_id,
-            bool is_anonymous, const string& text, const string& answer = "")
+            bool is_anonymous, string text, string answer = "")
             : id(id), parent_id(parent_id), from_user_id(from_user_id),
             to_user_id(to_user_id), is_anonymous(is_anonymous),
-            text(text), answer(answer) {}
+            text(move(text)), answer(move(answer)) {}
 
     // Returns the question's unique ID
     int getId() const { return id; }
@@ -150,12 +756,37 @@ public:
                 escapeCommas(answer);
     }
 
+    // Writes question data in the binary snapshot format
+    // Layout: id, parent_id, from, to, anonymous_flag, text, answer
+    void writeBinary(BinaryWriter& out) const {
+        out.WriteInt(id);
+        out.WriteInt(parent_id);
+        out.WriteInt(from_user_id);
+        out.WriteInt(to_user_id);
+        out.WriteU8(is_anonymous ? 1 : 0);
+        out.WriteString(text);
+        out.WriteString(answer);
+    }
+
+    // Reads a question written by writeBinary
+    // Note: Check in.Ok() afterwards to detect truncated data
+    static Question readBinary(BinaryReader& in) {
+        int id = in.ReadInt();
+        int parent_id = in.ReadInt();
+        int from_user_id = in.ReadInt();
+        int to_user_id = in.ReadInt();
+        bool is_anonymous = in.ReadU8() == 1;
+        string text = in.ReadString();
+        string answer = in.ReadString();
+        return Question(id, parent_id, from_user_id, to_user_id, is_anonymous, move(text), move(answer));
+    }
+
 private:
     // Helper method to make strings safe for CSV format
-    // Wraps text in quotes if it contains commas
+    // Wraps text in quotes if it contains commas or quotes
     // Doubles up existing quotes in the text
     string escapeCommas(const string& str) const {
-        if (str.find(',') != string::npos) {
+        if (str.find_first_of(",\"") != string::npos) {
             string escaped = str;
             size_t pos = 0;
             while ((pos = escaped.find('"', pos)) != string::npos) {
@@ -168,194 +799,928 @@ private:
     }
 };
 
+// Splits CPU-bound startup work (parsing data files, building indexes) across threads
+class ParallelWork {
+private:
+    static inline atomic<unsigned> thread_limit{0}; // 0 = one per hardware thread
+
+public:
+    // Caps the number of threads used (0 = one per hardware thread, 1 = run everything inline)
+    static void SetThreads(unsigned threads) {
+        thread_limit = threads;
+    }
+
+    // Gets the number of threads work may be split across
+    static unsigned GetThreads() {
+        unsigned limit = thread_limit;
+        return limit != 0 ? limit : max(1u, thread::hardware_concurrency());
+    }
+
+    // Decides how many parts to split `items` units of work into, so each part gets at least `min_items`
+    static size_t Workers(size_t items, size_t min_items) {
+        return max<size_t>(1, min<size_t>(GetThreads(), items / max<size_t>(min_items, 1)));
+    }
+
+    // Runs work(0) .. work(count - 1), each on its own thread (the first on the calling one), and waits for all
+    // The first exception thrown by any part is rethrown once every part has finished
+    template <class Work>
+    static void Run(size_t count, Work work) {
+        if (count <= 1 || GetThreads() == 1) {
+            for (size_t i = 0; i < count; ++i) {
+                work(i);
+            }
+            return;
+        }
+        vector<exception_ptr> errors(count);
+        vector<thread> threads;
+        threads.reserve(count - 1);
+        for (size_t i = 1; i < count; ++i) {
+            threads.emplace_back([&, i] {
+                try {
+                    work(i);
+                } catch (...) {
+                    errors[i] = current_exception();
+                }
+            });
+        }
+        try {
+            work(0);
+        } catch (...) {
+            errors[0] = current_exception();
+        }
+        for (thread& t : threads) {
+            t.join();
+        }
+        for (const exception_ptr& error : errors) {
+            if (error) {
+                rethrow_exception(error);
+            }
+        }
+    }
+};
+
+// Streams records out of a CSV data file without copying them line by line
+// The whole file is read into one buffer with a single read; fields are
+// string_views into that buffer, and only quoted fields that contain escaped
+// quotes ("") are materialized into scratch storage
+class CsvReader {
+private:
+    string buffer;                 // Entire file contents (unless attached to outside memory)
+    string_view contents;          // Text being read: `buffer` or the attached view
+    size_t position = 0;           // Start of the next unread line
+    string_view line;              // Current record, without the line break
+    vector<string_view> fields;    // Fields of the current record (reused per line)
+    deque<string> unescaped;       // Storage for fields that needed unescaping
+
+    // Splits the current line into fields, handling quoted fields
+    void SplitLine(char delimiter) {
+        fields.clear();
+        unescaped.clear();
+
+        size_t i = 0;
+        while (true) {
+            if (i < line.size() && line[i] == '"') {
+                // Quoted field - ends at a quote that isn't doubled
+                size_t start = ++i;
+                bool has_escapes = false;
+                while (i < line.size()) {
+                    if (line[i] == '"') {
+                        if (i + 1 < line.size() && line[i + 1] == '"') {
+                            has_escapes = true;
+                            i += 2;
+                            continue;
+                        }
+                        break;
+                    }
+                    ++i;
+                }
+                string_view raw = line.substr(start, i - start);
+                if (has_escapes) {
+                    string& field = unescaped.emplace_back();
+                    field.reserve(raw.size());
+                    for (size_t k = 0; k < raw.size(); ++k) {
+                        field += raw[k];
+                        if (raw[k] == '"') ++k; // Skip the second quote of the pair
+                    }
+                    raw = field;
+                }
+                fields.push_back(raw);
+                i = min(line.size(), i + 1); // Step over the closing quote
+                i = min(line.size(), line.find(delimiter, i));
+            } else {
+                size_t end = min(line.size(), line.find(delimiter, i));
+                fields.push_back(line.substr(i, end - i));
+                i = end;
+            }
+
+            if (i >= line.size()) break;
+            ++i; // Step over the delimiter
+        }
+    }
+
+public:
+    // Reads the whole file into memory
+    // Returns: False if the file can't be opened or read
+    bool Open(const string& file_path) {
+        ifstream file(file_path, ios::binary | ios::ate);
+        if (!file.is_open()) {
+            return false;
+        }
+        streamsize size = file.tellg();
+        file.seekg(0);
+        buffer.resize(size > 0 ? static_cast<size_t>(size) : 0);
+        contents = buffer;
+        position = 0;
+        return static_cast<bool>(file.read(buffer.data(), size));
+    }
+
+    // Reads records from text owned by the caller (e.g. one chunk of another reader's file)
+    // Note: The text must outlive the reader
+    void Attach(string_view text) {
+        buffer.clear();
+        contents = text;
+        position = 0;
+    }
+
+    // Gets the whole text being read
+    string_view Contents() const { return contents; }
+
+    // Upper bound on the number of records, useful for reserving containers
+    size_t CountLines() const {
+        return count(contents.begin(), contents.end(), '\n') + 1;
+    }
+
+    // Advances to the next non-empty record
+    // Returns: False once the end of the file is reached
+    bool Next(char delimiter = ',') {
+        while (position < contents.size()) {
+            size_t end = contents.find('\n', position);
+            if (end == string_view::npos) end = contents.size();
+            line = contents.substr(position, end - position);
+            position = end + 1;
+
+            if (!line.empty() && line.back() == '\r') {
+                line.remove_suffix(1);
+            }
+            if (!line.empty()) {
+                SplitLine(delimiter);
+                return true;
+            }
+        }
+        return false;
+    }
+
+    // Gets the raw text of the current record
+    string_view Line() const { return line; }
+
+    // Gets the fields of the current record
+    // Note: Views are valid until the next call to Next()
+    const vector<string_view>& Fields() const { return fields; }
+
+    // Parses a whole field as a decimal integer
+    // Returns: False if the field is empty, not a number, or has trailing characters
+    static bool ParseInt(string_view field, int& value) {
+        const char* end = field.data() + field.size();
+        auto [ptr, ec] = from_chars(field.data(), end, value);
+        return ec == errc() && ptr == end;
+    }
+};
+
 // Handles all file operations for user and question data
 // Manages reading, writing, and parsing of data files
+// Snapshots are stored either as CSV text or in a compact binary format
 class FileManager {
+public:
+    // On-disk layout of the snapshot files (the journal is always text)
+    enum StorageFormat {
+        CSV,    // Human-readable comma-separated lines
+        BINARY  // Versioned, checksummed, length-prefixed records
+    };
+
 private:
+    // Binary snapshot header: magic, version, record count, next ID, payload checksum
+    static constexpr uint32_t BINARY_VERSION = 1;
+    static constexpr string_view USERS_MAGIC = "AMU\x01";
+    static constexpr string_view QUESTIONS_MAGIC = "AMQ\x01";
+    static constexpr size_t BINARY_HEADER_SIZE = 20;
+
+    const StorageFormat format;       // Format of the snapshot files
     const string users_file_path;     // Path to users data file
-    const string questions_file_path; // Path to questions data file
-
-    // Splits a CSV line into tokens, handling quoted fields
-    // str: The input string to split
-    // delimiter: Character that separates fields (typically comma)
-    // Returns: Vector of string tokens with quotes removed
-    static vector<string> split(const string& str, char delimiter) {
-        vector<string> tokens;
-        string currentToken;
-        bool inQuotes = false;
-        
-        for (auto& c : str) {
-            if (c == '"') {
-                inQuotes = !inQuotes;
-            } else if (c == delimiter && !inQuotes) {
-                tokens.push_back(currentToken);
-                currentToken.clear();
+    const string questions_file_path; // Path to questions data file (the snapshot)
+    const string questions_journal_path; // Append-only log of question changes since the snapshot
+                                         // (one per snapshot file, e.g. questions.txt.journal)
+
+    // First line of a snapshot: "#next_id,<id>" keeps the ID high-water mark
+    // so IDs of deleted records are never handed out again
+    static constexpr string_view NEXT_ID_HEADER = "#next_id";
+
+    // Smallest share of a data file worth handing to its own parsing thread
+    static constexpr size_t PARALLEL_CHUNK_BYTES = 256 * 1024;
+
+    // Cuts text into at most `parts` consecutive pieces that each end on a line break
+    static vector<string_view> SplitOnLines(string_view text, size_t parts) {
+        vector<string_view> chunks;
+        size_t start = 0;
+        for (size_t i = 1; i <= parts && start < text.size(); ++i) {
+            size_t end = text.size();
+            if (i < parts) {
+                end = text.find('\n', max(start, text.size() / parts * i));
+                end = end == string_view::npos ? text.size() : end + 1;
+            }
+            chunks.push_back(text.substr(start, end - start));
+            start = end;
+        }
+        return chunks;
+    }
+
+    // Parses every record of a loaded CSV file; large files are cut into chunks on
+    // line boundaries and parsed in parallel, one reader per chunk
+    // parse: Builds one record from (fields, line, record), returning false to skip the line
+    // next_id: Raised past the header value and every parsed record's ID
+    // Returns: Parsed records grouped by chunk, in file order
+    template <class Record, class Parse>
+    static vector<vector<Record>> ParseRecords(const CsvReader& file, int& next_id, Parse parse) {
+        const vector<string_view> chunks = SplitOnLines(file.Contents(),
+            ParallelWork::Workers(file.Contents().size(), PARALLEL_CHUNK_BYTES));
+        vector<vector<Record>> records(chunks.size());
+        vector<int> next_ids(chunks.size(), next_id);
+        ParallelWork::Run(chunks.size(), [&](size_t c) {
+            CsvReader reader;
+            reader.Attach(chunks[c]);
+            while (reader.Next()) {
+                if (ReadNextIdHeader(reader.Fields(), next_ids[c])) {
+                    continue;
+                }
+                Record record;
+                if (parse(reader.Fields(), reader.Line(), record)) {
+                    next_ids[c] = max(next_ids[c], record.getId() + 1);
+                    records[c].push_back(move(record));
+                }
+            }
+        });
+        for (int id : next_ids) {
+            next_id = max(next_id, id);
+        }
+        return records;
+    }
+
+    // Applies every journal record, in order, on top of a loaded snapshot
+    // Records are "A,<question>" (add), "U,<question>" (update) or "D,<id>" (delete)
+    // next_question_id: Raised past every question ID seen in the journal
+    // Returns: Number of records found in the journal
+    size_t ReplayQuestionJournal(unordered_map<int, Question>& questions, int& next_question_id) const {
+        CsvReader journal;
+        if (!journal.Open(questions_journal_path)) {
+            return 0; // No journal yet - the snapshot is the whole state
+        }
+
+        size_t records = 0;
+        while (journal.Next()) {
+            ++records;
+
+            const vector<string_view>& tokens = journal.Fields();
+            if (tokens[0] == "A" || tokens[0] == "U") {
+                Question question;
+                if (ParseQuestion(tokens, 1, journal.Line(), question)) {
+                    next_question_id = max(next_question_id, question.getId() + 1);
+                    questions[question.getId()] = move(question);
+                }
+            } else if (tokens[0] == "D" && tokens.size() >= 2) {
+                int id;
+                if (CsvReader::ParseInt(tokens[1], id)) {
+                    questions.erase(id);
+                } else {
+                    cerr << "Error parsing journal line: " << journal.Line() << "\n";
+                }
             } else {
-                currentToken += c;
+                cerr << "Skipping unknown journal record: " << journal.Line() << "\n";
             }
         }
-        
-        tokens.push_back(currentToken);
-        return tokens;
+        return records;
     }
 
 public:
     // Initializes file paths with default locations
-    FileManager(const string& users_path = "users.txt", const string& questions_path = "questions.txt")
-        : users_file_path(users_path), questions_file_path(questions_path) {}
-
-    // Reads all lines from a text file
-    // file_path: The file to read from
-    // Returns: Vector of non-empty lines, or empty vector on error
-    vector<string> ReadInformationFromFile(const string& file_path) const {
-        ifstream file(file_path);
-        if (!file.is_open()) {
-            cerr << "Unable to open file: " << file_path << "\n";
-            return {};
+    FileManager(const string& users_path = "users.txt", const string& questions_path = "questions.txt",
+        StorageFormat format = CSV)
+        : format(format), users_file_path(users_path), questions_file_path(questions_path),
+        questions_journal_path(questions_path + ".journal") {}
+
+    // Reads the high-water mark header if this record is one
+    // Returns: True if the record was a header (and not data)
+    static bool ReadNextIdHeader(const vector<string_view>& tokens, int& next_id) {
+        if (tokens[0] != NEXT_ID_HEADER) {
+            return false;
         }
+        int stored;
+        if (tokens.size() >= 2 && CsvReader::ParseInt(tokens[1], stored)) {
+            next_id = max(next_id, stored);
+        }
+        return true;
+    }
 
-        vector<string> lines;
-        string line;
-        while (getline(file, line)) {
-            if (!line.empty()) {
-                lines.push_back(line);
-            }
+    // Formats a journal record for an added question
+    static string JournalAdd(const Question& question) {
+        return "A," + question.toString();
+    }
+
+    // Formats a journal record for an updated question
+    static string JournalUpdate(const Question& question) {
+        return "U," + question.toString();
+    }
+
+    // Formats a journal record for a deleted question
+    static string JournalDelete(int question_id) {
+        return "D," + to_string(question_id);
+    }
+
+    // Builds a User from the CSV fields of one users file line
+    // line: The raw line, used only for error reporting
+    // Returns: True if the fields describe a valid user
+    static bool ParseUser(const vector<string_view>& tokens, string_view line, User& user) {
+        if (tokens.size() < 7) {
+            cerr << "Skipping malformed user line (not enough tokens): " << line << "\n";
+            return false;
         }
-        file.close();
-        return lines;
+        
+        int id;
+        if (!CsvReader::ParseInt(tokens[0], id)) {
+            cerr << "Error parsing user line: " << line << "\n";
+            return false;
+        }
+        bool allowAnon = (tokens[5] == "1" || tokens[5] == "true");
+        User::Role role = (tokens[6] == "0" ? User::ADMIN : User::REGULAR_USER);
+        
+        user = User(id, string(tokens[1]), string(tokens[2]), string(tokens[3]), string(tokens[4]), allowAnon, role);
+        return true;
+    }
+
+    // Builds a Question from CSV fields starting at index `first`
+    // line: The raw line, used only for error reporting
+    // Returns: True if the fields describe a valid question
+    static bool ParseQuestion(const vector<string_view>& tokens, size_t first, string_view line, Question& question) {
+        if (tokens.size() < first + 6) {
+            cerr << "Skipping malformed question line: " << line << "\n";
+            return false;
+        }
+
+        int id, parentId, fromUserId, toUserId;
+        if (!CsvReader::ParseInt(tokens[first], id) || !CsvReader::ParseInt(tokens[first + 1], parentId) ||
+            !CsvReader::ParseInt(tokens[first + 2], fromUserId) || !CsvReader::ParseInt(tokens[first + 3], toUserId)) {
+            cerr << "Error parsing question line: " << line << "\n";
+            return false;
+        }
+
+        bool isAnon = (tokens[first + 4] == "1" || tokens[first + 4] == "true");
+        string_view answer = tokens.size() >= first + 7 ? tokens[first + 6] : string_view();
+        question = Question(id, parentId, fromUserId, toUserId, isAnon, string(tokens[first + 5]), string(answer));
+        return true;
     }
 
     // Writes multiple lines to a file (overwrites existing content)
     // file_path: Destination file path
     // lines: Content to write
     // Returns: True if successful, false on error
+    // Note: Writes to a temporary file first and renames it into place,
+    //       so a crash never leaves a half-written file behind
     bool StoreInformationOnFile(const string& file_path, const vector<string>& lines) const {
-        ofstream file(file_path);
+        string contents;
+        for (const auto& line : lines) {
+            contents += line;
+            contents += '\n';
+        }
+        return StoreBufferOnFile(file_path, contents);
+    }
+
+    // Writes raw bytes to a file (overwrites existing content)
+    // Note: Same temporary-file-and-rename strategy as StoreInformationOnFile
+    bool StoreBufferOnFile(const string& file_path, string_view contents) const {
+        ASKME_TRACE_SCOPE("FileManager::StoreBufferOnFile");
+        ASKME_TRACE_COUNT("Snapshot bytes written", contents.size());
+        const string temp_path = file_path + ".tmp";
+        ofstream file(temp_path, ios::binary);
         if (!file.is_open()) {
-            cerr << "Unable to open file for writing: " << file_path << "\n";
+            cerr << "Unable to open file for writing: " << temp_path << "\n";
             return false;
         }
         
-        for (const auto& line : lines) {
-            file << line << "\n";
-        }
+        file.write(contents.data(), contents.size());
         file.close();
+        if (!file) {
+            cerr << "Failed writing file: " << temp_path << "\n";
+            return false;
+        }
+
+        error_code ec;
+        filesystem::rename(temp_path, file_path, ec);
+        if (ec) {
+            cerr << "Unable to replace file: " << file_path << " (" << ec.message() << ")\n";
+            return false;
+        }
         return true;
     }
+
+    // Appends records to the questions journal in a single write
+    // records: Lines built by JournalAdd/JournalUpdate/JournalDelete
+    // Returns: True if successful, false on error
+    bool AppendToJournal(const vector<string>& records) const {
+        ASKME_TRACE_SCOPE("FileManager::AppendToJournal");
+        string contents;
+        for (const auto& record : records) {
+            contents += record;
+            contents += '\n';
+        }
+
+        ofstream journal(questions_journal_path, ios::app | ios::binary);
+        if (!journal.is_open()) {
+            cerr << "Unable to open journal for writing: " << questions_journal_path << "\n";
+            return false;
+        }
+        ASKME_TRACE_COUNT("Journal bytes written", contents.size());
+        ASKME_TRACE_COUNT("Journal records per write", records.size());
+        journal.write(contents.data(), contents.size());
+        return static_cast<bool>(journal);
+    }
     
+    // Writes a binary snapshot: header followed by the encoded records
+    // payload: Records encoded with writeBinary
+    bool StoreBinaryFile(const string& file_path, string_view magic, const BinaryWriter& payload,
+        size_t record_count, int next_id) const {
+        BinaryWriter header;
+        for (char c : magic) header.WriteU8(static_cast<uint8_t>(c));
+        header.WriteU32(BINARY_VERSION);
+        header.WriteU32(static_cast<uint32_t>(record_count));
+        header.WriteInt(next_id);
+        header.WriteU32(BinaryWriter::Checksum(payload.Buffer()));
+        return StoreBufferOnFile(file_path, header.Buffer() + payload.Buffer());
+    }
+
+    // Reads and validates a binary snapshot
+    // contents: Receives the whole file; record_count/next_id come from the header
+    // Returns: False if the file doesn't exist
+    // Throws: runtime_error if the file is truncated, corrupted or from another version
+    bool ReadBinaryFile(const string& file_path, string_view magic, string& contents,
+        uint32_t& record_count, int& next_id) const {
+        ifstream file(file_path, ios::binary | ios::ate);
+        if (!file.is_open()) {
+            return false;
+        }
+        streamsize size = file.tellg();
+        file.seekg(0);
+        contents.resize(size > 0 ? static_cast<size_t>(size) : 0);
+        file.read(contents.data(), size);
+
+        if (!file || contents.size() < BINARY_HEADER_SIZE || string_view(contents).substr(0, 4) != magic) {
+            throw runtime_error("Not a valid binary data file: " + file_path);
+        }
+        BinaryReader header(string_view(contents).substr(4, BINARY_HEADER_SIZE - 4));
+        if (header.ReadU32() != BINARY_VERSION) {
+            throw runtime_error("Unsupported binary data file version: " + file_path);
+        }
+        record_count = header.ReadU32();
+        next_id = header.ReadInt();
+        uint32_t checksum = header.ReadU32();
+        if (BinaryWriter::Checksum(string_view(contents).substr(BINARY_HEADER_SIZE)) != checksum) {
+            throw runtime_error("Checksum mismatch in binary data file: " + file_path);
+        }
+        return true;
+    }
+
+    // Loads users from a binary snapshot
+    unordered_map<int, User> LoadUsersBinary(int& next_user_id) const {
+        unordered_map<int, User> users;
+        string contents;
+        uint32_t count = 0;
+        if (!ReadBinaryFile(users_file_path, USERS_MAGIC, contents, count, next_user_id)) {
+            cerr << "Unable to open file: " << users_file_path << "\n";
+            next_user_id = 1;
+            return users;
+        }
+
+        BinaryReader reader(string_view(contents).substr(BINARY_HEADER_SIZE));
+        users.reserve(count);
+        for (uint32_t i = 0; i < count; ++i) {
+            User user = User::readBinary(reader);
+            if (!reader.Ok()) {
+                throw runtime_error("Truncated binary data file: " + users_file_path);
+            }
+            next_user_id = max(next_user_id, user.getId() + 1);
+            users.emplace(user.getId(), move(user));
+        }
+        return users;
+    }
+
+    // Loads questions from a binary snapshot (without the journal)
+    unordered_map<int, Question> LoadQuestionsBinary(int& next_question_id) const {
+        unordered_map<int, Question> questions;
+        string contents;
+        uint32_t count = 0;
+        if (!ReadBinaryFile(questions_file_path, QUESTIONS_MAGIC, contents, count, next_question_id)) {
+            cerr << "Unable to open file: " << questions_file_path << "\n";
+            next_question_id = 1;
+            return questions;
+        }
+
+        BinaryReader reader(string_view(contents).substr(BINARY_HEADER_SIZE));
+        questions.reserve(count);
+        for (uint32_t i = 0; i < count; ++i) {
+            Question question = Question::readBinary(reader);
+            if (!reader.Ok()) {
+                throw runtime_error("Truncated binary data file: " + questions_file_path);
+            }
+            next_question_id = max(next_question_id, question.getId() + 1);
+            questions.emplace(question.getId(), move(question));
+        }
+        return questions;
+    }
+
     // Loads all users from the users file
     // Returns: Map of user_id to User objects
     // Note: Skips malformed lines but logs errors
     unordered_map<int, User> LoadUsers() const {
+        int next_user_id = 1;
+        return LoadUsers(next_user_id);
+    }
+
+    // Same as LoadUsers() but also reports the user ID high-water mark
+    // next_user_id: Receives the first ID that has never been used
+    unordered_map<int, User> LoadUsers(int& next_user_id) const {
+        ASKME_TRACE_SCOPE("FileManager::LoadUsers");
+        if (format == BINARY) {
+            return LoadUsersBinary(next_user_id);
+        }
+
         unordered_map<int, User> users;
-        vector<string> lines = ReadInformationFromFile(users_file_path);
-        
-        for (const auto& line : lines) {
-            vector<string> tokens = split(line, ',');
-            if (tokens.size() < 7) {
-                cerr << "Skipping malformed user line (not enough tokens): " << line << "\n";
-                continue;
-            }
-            
-            try {
-                int id = stoi(tokens[0]);
-                string name = tokens[1];
-                string password = tokens[2];
-                string username = tokens[3];
-                string email = tokens[4];
-                bool allowAnon = (tokens[5] == "1" || tokens[5] == "true");
-                User::Role role = (tokens[6] == "0" ? User::ADMIN : User::REGULAR_USER);
-                
-                users.emplace(id, User(id, name, password, username, email, allowAnon, role));
-            } catch (const exception& e) {
-                cerr << "Error parsing user line: " << line << "\n" << "Exception: " << e.what() << "\n";
-                continue;
+        next_user_id = 1;
+        CsvReader reader;
+        if (!reader.Open(users_file_path)) {
+            cerr << "Unable to open file: " << users_file_path << "\n";
+            return users;
+        }
+        users.reserve(reader.CountLines());
+
+        // Merged in file order, so the first of two records with the same ID wins as before
+        for (vector<User>& chunk : ParseRecords<User>(reader, next_user_id, ParseUser)) {
+            for (User& user : chunk) {
+                int id = user.getId();
+                users.emplace(id, move(user));
             }
         }
         return users;
     }
     
-    // Loads all questions from the questions file
+    // Loads all questions from the questions snapshot and replays the journal on top of it
     // Returns: Map of question_id to Question objects
     // Note: Handles both parent and thread questions
     unordered_map<int, Question> LoadQuestions() const {
+        size_t journal_records = 0;
+        int next_question_id = 1;
+        return LoadQuestions(journal_records, next_question_id);
+    }
+
+    // Same as LoadQuestions() but also reports the journal size and ID high-water mark
+    // journal_records: Receives the number of records in the journal tail
+    // next_question_id: Receives the first ID that has never been used
+    unordered_map<int, Question> LoadQuestions(size_t& journal_records, int& next_question_id) const {
+        ASKME_TRACE_SCOPE("FileManager::LoadQuestions");
         unordered_map<int, Question> questions;
-        vector<string> lines = ReadInformationFromFile(questions_file_path);
-        
-        for (const auto& line : lines) {
-            vector<string> tokens = split(line, ',');
-            if (tokens.size() < 6) {
-                cerr << "Skipping malformed question line: " << line << "\n";
-                continue;
-            }
-            
-            try {
-                int id = stoi(tokens[0]);
-                int parentId = stoi(tokens[1]);
-                int fromUserId = stoi(tokens[2]);
-                int toUserId = stoi(tokens[3]);
-                bool isAnon = (tokens[4] == "1" || tokens[4] == "true");
-                string text = tokens[5];
-                string answer = tokens.size() >= 7 ? tokens[6] : "";
-                
-                questions.emplace(id, Question(id, parentId, fromUserId, toUserId, isAnon, text, answer));
-            } catch (const exception& e) {
-                cerr << "Error parsing question line: " << line << "\n" << "Exception: " << e.what() << "\n";
-                continue;
+        next_question_id = 1;
+        CsvReader reader;
+        if (format == BINARY) {
+            questions = LoadQuestionsBinary(next_question_id);
+        } else if (reader.Open(questions_file_path)) {
+            questions.reserve(reader.CountLines());
+            auto parse = [](const vector<string_view>& fields, string_view line, Question& question) {
+                return ParseQuestion(fields, 0, line, question);
+            };
+            for (vector<Question>& chunk : ParseRecords<Question>(reader, next_question_id, parse)) {
+                for (Question& question : chunk) {
+                    int id = question.getId();
+                    questions.emplace(id, move(question));
+                }
             }
+        } else {
+            cerr << "Unable to open file: " << questions_file_path << "\n";
         }
+
+        journal_records = ReplayQuestionJournal(questions, next_question_id);
         return questions;
     }
     
     // Saves all users to the users file
     // users: Map of users to save
+    // next_user_id: ID high-water mark, stored in the file header
     // Returns: True if successful, false on error
-    bool SaveUsers(const unordered_map<int, User>& users) const {
+    bool SaveUsers(const unordered_map<int, User>& users, int next_user_id) const {
+        ASKME_TRACE_SCOPE("FileManager::SaveUsers");
+        if (format == BINARY) {
+            BinaryWriter payload;
+            for (const auto& pair : users) {
+                pair.second.writeBinary(payload);
+            }
+            return StoreBinaryFile(users_file_path, USERS_MAGIC, payload, users.size(), next_user_id);
+        }
+
         vector<string> lines;
+        lines.reserve(users.size() + 1);
+        lines.push_back(string(NEXT_ID_HEADER) + "," + to_string(next_user_id));
         for (const auto& pair : users) {
             lines.push_back(pair.second.toString());
         }
         return StoreInformationOnFile(users_file_path, lines);
     }
     
-    // Saves all questions to the questions file
+    // Saves all questions to the questions file as a fresh snapshot
     // questions: Map of questions to save
+    // next_question_id: ID high-water mark, stored in the file header
     // Returns: True if successful, false on error
-    bool SaveQuestions(const unordered_map<int, Question>& questions) const {
-        vector<string> lines;
-        for (const auto& pair : questions) {
-            lines.push_back(pair.second.toString());
+    // Note: The journal is cleared once the snapshot is in place
+    bool SaveQuestions(const unordered_map<int, Question>& questions, int next_question_id) const {
+        ASKME_TRACE_SCOPE("FileManager::SaveQuestions");
+        ASKME_TRACE_COUNT("Questions per snapshot", questions.size());
+        bool stored;
+        if (format == BINARY) {
+            BinaryWriter payload;
+            for (const auto& pair : questions) {
+                pair.second.writeBinary(payload);
+            }
+            stored = StoreBinaryFile(questions_file_path, QUESTIONS_MAGIC, payload, questions.size(), next_question_id);
+        } else {
+            vector<string> lines;
+            lines.reserve(questions.size() + 1);
+            lines.push_back(string(NEXT_ID_HEADER) + "," + to_string(next_question_id));
+            for (const auto& pair : questions) {
+                lines.push_back(pair.second.toString());
+            }
+            stored = StoreInformationOnFile(questions_file_path, lines);
+        }
+        if (!stored) {
+            return false;
+        }
+
+        ofstream journal(questions_journal_path, ios::trunc);
+        return journal.is_open();
+    }
+
+    // Replaces legacy plaintext passwords with salted hashes, hashing on several threads
+    // Returns: Number of passwords that were hashed
+    static size_t HashPlaintextPasswords(unordered_map<int, User>& users) {
+        vector<User*> legacy;
+        for (auto& [id, user] : users) {
+            if (!PasswordHasher::IsHashed(user.getPasswordHash())) {
+                legacy.push_back(&user);
+            }
+        }
+        const size_t workers = ParallelWork::Workers(legacy.size(), 1);
+        ParallelWork::Run(workers, [&](size_t part) {
+            for (size_t i = part; i < legacy.size(); i += workers) {
+                legacy[i]->setPassword(legacy[i]->getPasswordHash());
+            }
+        });
+        return legacy.size();
+    }
+
+    // Copies all data from one set of files to another (e.g. CSV to binary)
+    // source: Files to read, including any journal on top of the snapshot
+    // target: Files to write; their journal is cleared
+    // Returns: True if successful, false on error
+    static bool Convert(const FileManager& source, const FileManager& target) {
+        if (!filesystem::exists(source.users_file_path) || !filesystem::exists(source.questions_file_path)) {
+            cerr << "Nothing to convert: " << source.users_file_path << " or "
+                << source.questions_file_path << " is missing\n";
+            return false;
+        }
+
+        int next_user_id, next_question_id;
+        size_t journal_records;
+        unordered_map<int, User> users = source.LoadUsers(next_user_id);
+        unordered_map<int, Question> questions = source.LoadQuestions(journal_records, next_question_id);
+        HashPlaintextPasswords(users);
+        if (!target.SaveUsers(users, next_user_id) || !target.SaveQuestions(questions, next_question_id)) {
+            return false;
+        }
+
+        cout << "Converted " << users.size() << " users and " << questions.size() << " questions to "
+            << target.users_file_path << " and " << target.questions_file_path << "\n";
+        return true;
+    }
+};
+
+// Controls when in-memory changes are written to disk
+// The default policy writes every change immediately (write-through)
+struct PersistencePolicy {
+    size_t max_pending_changes = 1;       // Flush once this many changes are pending
+    chrono::milliseconds max_delay{0};    // Flush once the oldest pending change is this old (0 = no limit)
+
+    // Every change is written before the call returns
+    static PersistencePolicy WriteThrough() {
+        return PersistencePolicy();
+    }
+
+    // Changes are collected and written in bursts
+    // changes: Pending change count that forces a flush
+    // delay: Age of the oldest pending change that forces a flush
+    static PersistencePolicy WriteBehind(size_t changes, chrono::milliseconds delay) {
+        PersistencePolicy policy;
+        policy.max_pending_changes = max<size_t>(changes, 1);
+        policy.max_delay = delay;
+        return policy;
+    }
+
+    // Nothing is written until Flush() is called explicitly
+    static PersistencePolicy Manual() {
+        return WriteBehind(numeric_limits<size_t>::max(), chrono::milliseconds(0));
+    }
+};
+
+// Tracks unsaved changes and decides, based on a PersistencePolicy, when they're due
+class DirtyTracker {
+private:
+    PersistencePolicy policy;                   // When pending changes must be written
+    size_t pending_changes = 0;                 // Changes since the last flush
+    chrono::steady_clock::time_point oldest;    // Time of the first pending change
+
+public:
+    DirtyTracker(const PersistencePolicy& policy) : policy(policy) {}
+
+    // Records that a change has been made in memory
+    void MarkDirty() {
+        if (pending_changes++ == 0) {
+            oldest = chrono::steady_clock::now();
         }
-        return StoreInformationOnFile(questions_file_path, lines);
     }
+
+    // Records that all pending changes have been written
+    void MarkClean() {
+        pending_changes = 0;
+    }
+
+    // Checks if there are unsaved changes
+    bool IsDirty() const {
+        return pending_changes > 0;
+    }
+
+    // Checks if the policy requires the pending changes to be written now
+    bool IsDue() const {
+        if (pending_changes == 0) return false;
+        if (pending_changes >= policy.max_pending_changes) return true;
+        return policy.max_delay.count() > 0 && chrono::steady_clock::now() - oldest >= policy.max_delay;
+    }
+
+    // Replaces the policy (pending changes are kept)
+    void SetPolicy(const PersistencePolicy& new_policy) {
+        policy = new_policy;
+    }
+
+    // Gets the current policy
+    const PersistencePolicy& GetPolicy() const {
+        return policy;
+    }
+};
+
+// Owns the in-memory copy of all persisted data
+// Loads each data file exactly once; every service works on it by reference
+class DataStore {
+private:
+    FileManager file_manager;               // Handles file system operations
+    unordered_map<int, User> users;         // Maps user IDs to User objects
+    unordered_map<int, Question> questions; // Maps question IDs to Question objects
+    size_t question_journal_records = 0;    // Journal records replayed at startup
+    int next_user_id = 1;                   // User ID high-water mark (IDs are never reused)
+    int next_question_id = 1;               // Question ID high-water mark (IDs are never reused)
+
+public:
+    // Loads users and questions from persistent storage
+    // The two files are independent, so they're loaded at the same time
+    DataStore(const FileManager& fm = FileManager()) : file_manager(fm) {
+        ParallelWork::Run(2, [&](size_t part) {
+            if (part == 0) {
+                questions = file_manager.LoadQuestions(question_journal_records, next_question_id);
+            } else {
+                users = file_manager.LoadUsers(next_user_id);
+            }
+        });
+    }
+
+    // Store must stay unique - services keep references into it
+    DataStore(const DataStore&) = delete;
+    DataStore& operator=(const DataStore&) = delete;
+
+    // Gets the file manager used to persist this store
+    const FileManager& GetFileManager() const { return file_manager; }
+
+    // Gets the shared user table
+    unordered_map<int, User>& GetUsers() { return users; }
+
+    // Gets the shared question table
+    unordered_map<int, Question>& GetQuestions() { return questions; }
+
+    // Gets the number of journal records on top of the question snapshot
+    size_t GetQuestionJournalRecords() const { return question_journal_records; }
+
+    // Gets the shared user ID counter
+    int& GetNextUserIDCounter() { return next_user_id; }
+
+    // Gets the shared question ID counter
+    int& GetNextQuestionIDCounter() { return next_question_id; }
 };
 
 // Manages all user-related operations including CRUD operations and authentication
 // Handles persistence through FileManager and maintains in-memory user data
+// Thread-safe: lookups share a reader lock, changes take the writer lock
 class UserManager {
 private:
-    unordered_map<int, User> users;  // Maps user IDs to User objects
-    FileManager file_manager;        // Handles file system operations
+    unordered_map<int, User>& users;  // Maps user IDs to User objects (owned by DataStore)
+    const FileManager& file_manager;  // Handles file system operations
+    int& next_user_id;                // First never-used user ID (owned by DataStore)
+    DirtyTracker dirty;               // Unsaved changes waiting for a flush
+    mutable shared_mutex mutex;       // Guards everything above
+
+    // Verified-login cache: user ID -> keyed fingerprint of (password, stored hash)
+    // Repeated logins skip the slow hash; a changed hash can never match an old entry
+    static constexpr size_t LOGIN_CACHE_SIZE = 1024;
+    const string cache_key = PasswordHasher::RandomBytes(32); // Per process, so fingerprints mean nothing elsewhere
+    unordered_map<int, string> login_cache;
+    mutable std::mutex cache_mutex;        // Guards login_cache (taken without, or after, `mutex`)
+
+    // Drops a user's cached login
+    void ForgetLogin(int user_id) {
+        lock_guard lock(cache_mutex);
+        login_cache.erase(user_id);
+    }
+
+    // Flush() for callers that already hold the writer lock
+    bool FlushLocked() {
+        if (!dirty.IsDirty()) {
+            return true;
+        }
+        if (!file_manager.SaveUsers(users, next_user_id)) {
+            return false;
+        }
+        dirty.MarkClean();
+        return true;
+    }
+
+    // FlushIfDue() for callers that already hold the writer lock
+    bool FlushIfDueLocked() {
+        return dirty.IsDue() ? FlushLocked() : true;
+    }
 
 public:
-    // Initializes UserManager by loading users from persistent storage
-    UserManager() : file_manager("users.txt", "questions.txt") {
-        users = file_manager.LoadUsers();
+    // Initializes UserManager on top of the shared data store
+    // policy: When changes are written to the users file (default: immediately)
+    // Legacy plaintext passwords are hashed and written back right away, whatever the policy
+    UserManager(DataStore& store, const PersistencePolicy& policy = PersistencePolicy::WriteThrough())
+        : users(store.GetUsers()), file_manager(store.GetFileManager()),
+        next_user_id(store.GetNextUserIDCounter()), dirty(policy) {
+        if (FileManager::HashPlaintextPasswords(users) > 0) {
+            dirty.MarkDirty();
+            Flush();
+        }
+    }
+
+    // Writes any pending changes before going away
+    ~UserManager() {
+        Flush();
     }
-    UserManager(const FileManager& fm) : file_manager(fm) {
-        users = file_manager.LoadUsers();
+
+    // Writes all pending changes to the users file now
+    // Returns: True if nothing was pending or the write succeeded
+    bool Flush() {
+        unique_lock lock(mutex);
+        return FlushLocked();
+    }
+
+    // Flushes only if the persistence policy says the pending changes are due
+    bool FlushIfDue() {
+        unique_lock lock(mutex);
+        return FlushIfDueLocked();
+    }
+
+    // Changes when pending changes are written
+    void SetPersistencePolicy(const PersistencePolicy& policy) {
+        unique_lock lock(mutex);
+        dirty.SetPolicy(policy);
+    }
+
+    // Gets the policy that decides when changes are written
+    PersistencePolicy GetPersistencePolicy() const {
+        shared_lock lock(mutex);
+        return dirty.GetPolicy();
     }
 
     // Displays all users in the system with their basic information
     // Format: ID [tab] Name [tab] Role (Admin/User)
-    void ListSystemUsers() const {
+    void ListSystemUsers(ostream& stream = cout) const {
+        shared_lock lock(mutex);
+        OutputBuffer out(stream);
         if (users.empty()) {
-            cout << "No users found\n";
+            out << "No users found\n";
             return;
         }
         
         for (const auto& [id, user] : users) {
-            cout << "ID: " << id << "\tName: " << user.getName() << "\tRole: "
+            out << "ID: " << id << "\tName: " << user.getName() << "\tRole: "
             << (user.getRole() == User::ADMIN ? "Admin" : "User") << '\n';
         }
     }
@@ -363,22 +1728,27 @@ public:
     // Updates an existing user's information
     // updated_user: User object containing new data (must have existing ID)
     // Returns: true if update successful, false if user doesn't exist
-    // Note: Changes are automatically persisted to file
+    // Note: Changes are persisted according to the persistence policy
     bool UpdateUser(const User& updated_user) {
+        unique_lock lock(mutex);
         if (!users.count(updated_user.getId())) {
             cerr << "User not found\n";
             return false;
         }
         
         users[updated_user.getId()] = updated_user;
-        return file_manager.SaveUsers(users);
+        ForgetLogin(updated_user.getId());
+        dirty.MarkDirty();
+        return FlushIfDueLocked();
     }
 
     // Retrieves a user by their unique ID
     // user_id: The ID to search for
-    // Returns: Const reference to the User object
+    // Returns: A copy of the User object (other sessions may change the stored one)
     // Throws: runtime_error if user not found
-    const User& GetUserByID(int user_id) const {
+    User GetUserByID(int user_id) const {
+        ASKME_TRACE_SCOPE("UserManager::GetUserByID");
+        shared_lock lock(mutex);
         auto it = users.find(user_id);
         if (it == users.end()) {
             throw runtime_error("User not found");
@@ -389,34 +1759,44 @@ public:
     // Adds a new user to the system
     // user: The User object to add
     // Returns: True if added successfully, false if user ID already exists
-    // Note: Automatically persists changes to file
+    // Note: Changes are persisted according to the persistence policy
     bool AddUser(const User& user) {
+        unique_lock lock(mutex);
         if (!users.emplace(user.getId(), user).second) {
             cerr << "User ID already exists\n";
             return false;
         }
-        return file_manager.SaveUsers(users);
+        next_user_id = max(next_user_id, user.getId() + 1);
+        dirty.MarkDirty();
+        return FlushIfDueLocked();
     }
 
-    // Generates the next available user ID
-    // Returns: Highest existing ID + 1, or 1 if no users exist
+    // Gets the next available user ID without reserving it
+    // Returns: First ID that was never used, even by a deleted user
     int GetNextUserID() const {
-        if (users.empty()) return 1;
-        int maxId = 0;
-        for (const auto& pair : users) {
-            maxId = max(maxId, pair.first);
-        }
-        return maxId + 1;
+        shared_lock lock(mutex);
+        return next_user_id;
+    }
+
+    // Reserves a fresh user ID, so repeated calls never collide
+    // Returns: An ID no other call (or stored user) will get
+    int AllocateUserID() {
+        unique_lock lock(mutex);
+        return next_user_id++;
     }
 
     // Removes a user from the system
     // user_id: ID of the user to delete
+    // out: Receives the confirmation message
     // Returns: True if user existed and was deleted, false otherwise
-    // Note: Automatically persists changes to file
-    bool DeleteUser(int user_id) {
+    // Note: Changes are persisted according to the persistence policy
+    bool DeleteUser(int user_id, ostream& out = cout) {
+        unique_lock lock(mutex);
         if (users.erase(user_id)) {
-            cout << "[Success] Deleted user ID: " << user_id << "\n";
-            return file_manager.SaveUsers(users);
+            ForgetLogin(user_id);
+            out << "[Success] Deleted user ID: " << user_id << "\n";
+            dirty.MarkDirty();
+            return FlushIfDueLocked();
         }
         return false;
     }
@@ -425,28 +1805,71 @@ public:
     // user_id: ID of the user to authenticate
     // password: Plaintext password to verify
     // Returns: True if credentials are valid, false otherwise
-    bool Authenticate(int user_id, const string& password) const {
-        auto it = users.find(user_id);
-        return it != users.end() && it->second.verifyPassword(password);
+    // Note: Legacy plaintext passwords (and hashes below the current work factor)
+    //       are re-hashed after a successful login
+    bool Authenticate(int user_id, const string& password) {
+        ASKME_TRACE_SCOPE("UserManager::Authenticate");
+        string stored;
+        {
+            shared_lock lock(mutex);
+            auto it = users.find(user_id);
+            if (it == users.end()) {
+                return false;
+            }
+            stored = it->second.getPasswordHash();
+        }
+
+        string fingerprint = PasswordHasher::Fingerprint(cache_key, password + '\0' + stored);
+        {
+            lock_guard lock(cache_mutex);
+            auto it = login_cache.find(user_id);
+            if (it != login_cache.end() && PasswordHasher::ConstantTimeEquals(it->second, fingerprint)) {
+                return true;
+            }
+        }
+
+        // The slow hash runs without holding any lock
+        if (!PasswordHasher::Verify(password, stored)) {
+            return false;
+        }
+        if (PasswordHasher::NeedsRehash(stored)) {
+            string upgraded = PasswordHasher::Hash(password);
+            unique_lock lock(mutex);
+            auto it = users.find(user_id);
+            if (it != users.end() && it->second.getPasswordHash() == stored) {
+                it->second.setPasswordHash(upgraded);
+                dirty.MarkDirty();
+                FlushIfDueLocked();
+                fingerprint = PasswordHasher::Fingerprint(cache_key, password + '\0' + upgraded);
+            }
+        }
+
+        lock_guard lock(cache_mutex);
+        if (login_cache.size() >= LOGIN_CACHE_SIZE && !login_cache.count(user_id)) {
+            login_cache.erase(login_cache.begin());
+        }
+        login_cache[user_id] = move(fingerprint);
+        return true;
     }
-};
 
+    // Forgets every cached login, so the next ones run the full hash
+    void ClearLoginCache() {
+        lock_guard lock(cache_mutex);
+        login_cache.clear();
+    }
+};
 
 // Handles user authentication and registration
 // Manages login state and integrates with UserManager for user operations
 class AuthService {
 private:
-    unordered_map<int, User> users; // Local cache of users
     UserManager& user_manager;       // Handles user operations
-    FileManager file_manager;       // Handles file operations
     User current_user;              // Currently logged-in user
     bool is_logged_in = false;      // Track login state
 
 public:
-    // Initializes service and loads users from file
-    AuthService(UserManager& um) : user_manager(um) {
-        users = file_manager.LoadUsers();
-    }
+    // Initializes service on top of the shared user manager
+    AuthService(UserManager& um) : user_manager(um) {}
     
     // Handles user login process
     // Throws: runtime_error if authentication fails
@@ -460,15 +1883,28 @@ public:
         string password;
         cin >> password;
         
-        if (user_manager.Authenticate(user_id, password)) {
-            current_user = user_manager.GetUserByID(user_id);
-            is_logged_in = true;
+        if (Login(user_id, password)) {
             cout << "\nLogin successful! Welcome, " << current_user.getName() << ".\n";
         } else {
             throw runtime_error("Invalid information - Please check your ID and password and try again...\n");
         }
     }
 
+    // Logs in with known credentials, without prompting
+    // Returns: True if the credentials are valid
+    bool Login(int user_id, const string& password) {
+        if (!user_manager.Authenticate(user_id, password)) {
+            return false;
+        }
+        try {
+            current_user = user_manager.GetUserByID(user_id);
+        } catch (const runtime_error&) {
+            return false; // Deleted by another session in the meantime
+        }
+        is_logged_in = true;
+        return true;
+    }
+
     // Handles new user registration
     // Throws: runtime_error if registration fails
     void SignUp() {
@@ -495,13 +1931,14 @@ public:
         cin >> allow_anon;
 
         User new_user(
-            user_manager.GetNextUserID(),
+            user_manager.AllocateUserID(),
             name,
-            password,
+            "",
             username,
             email,
             allow_anon == 1
         );
+        new_user.setPassword(password);
 
         if (user_manager.AddUser(new_user)) {
             current_user = new_user;
@@ -529,66 +1966,413 @@ public:
     }
 
     // Logs out the current user
-    void Logout() {
+    void Logout(ostream& out = cout) {
         current_user = User(); // Reset to empty user
         is_logged_in = false;
-        cout << "Successfully logged out.\n";
+        out << "Successfully logged out.\n";
     }
 };
 
 
 // Manages all question-related operations including creation, answering, and display
 // Handles question threading and persistence through FileManager
+// Thread-safe: views share a reader lock, changes take the writer lock
+// Lock order: a caller holding this lock never waits on UserManager's
 class QuestionManager {
 private:
-    unordered_map<int, Question> questions; // Maps question IDs to Question objects
+    unordered_map<int, Question>& questions; // Maps question IDs to Question objects (owned by DataStore)
     UserManager& user_manager;              // Reference to user manager
-    FileManager file_manager;               // Handles file system operations
+    const FileManager& file_manager;        // Handles file system operations
+    size_t journal_records;                 // Journal records written since the last snapshot
+    int& next_question_id;                  // First never-used question ID (owned by DataStore)
+    size_t compaction_threshold;            // Journal size that triggers a new snapshot
+    vector<string> pending_records;         // Journal records not written yet
+    DirtyTracker dirty;                     // Decides when pending records are written
+    mutable shared_mutex mutex;             // Guards the questions, the indexes and the journal state
+
+    // Secondary indexes kept in sync with `questions` (IDs are kept sorted)
+    unordered_map<int, set<int>> questions_to_user;   // Recipient user ID -> question IDs
+    unordered_map<int, set<int>> questions_from_user; // Asker user ID -> question IDs
+    unordered_map<int, set<int>> thread_children;     // Parent question ID -> thread question IDs
+    set<int> question_ids;                            // Every question ID, in order (feed paging)
+
+    // Full-text index over question and answer text: term -> (question ID -> occurrences)
+    unordered_map<string, unordered_map<int, int>> search_index;
+
+    // Splits text into lowercase alphanumeric terms
+    static vector<string> Tokenize(string_view text) {
+        vector<string> terms;
+        string term;
+        for (char ch : text) {
+            if (isalnum(static_cast<unsigned char>(ch))) {
+                term += static_cast<char>(tolower(static_cast<unsigned char>(ch)));
+            } else if (!term.empty()) {
+                terms.push_back(move(term));
+                term.clear();
+            }
+        }
+        if (!term.empty()) {
+            terms.push_back(move(term));
+        }
+        return terms;
+    }
+
+    // Adds (delta = 1) or removes (delta = -1) a question's terms in the search index
+    void UpdateSearchIndex(const Question& q, int delta) {
+        for (string_view text : {string_view(q.getText()), string_view(q.getAnswer())}) {
+            for (string& term : Tokenize(text)) {
+                auto postings = search_index.find(term);
+                if (delta > 0) {
+                    search_index[move(term)][q.getId()] += delta;
+                } else if (postings != search_index.end()) {
+                    auto posting = postings->second.find(q.getId());
+                    if (posting != postings->second.end() && (posting->second += delta) <= 0) {
+                        postings->second.erase(posting);
+                        if (postings->second.empty()) {
+                            search_index.erase(postings);
+                        }
+                    }
+                }
+            }
+        }
+    }
+
+    // Adds a question to every secondary index
+    void IndexQuestion(const Question& q) {
+        question_ids.insert(q.getId());
+        UpdateSearchIndex(q, 1);
+        questions_to_user[q.getToUserId()].insert(q.getId());
+        questions_from_user[q.getFromUserId()].insert(q.getId());
+        if (q.getParentId() != -1) {
+            thread_children[q.getParentId()].insert(q.getId());
+        }
+    }
+
+    // Smallest number of questions worth handing to their own indexing thread
+    static constexpr size_t PARALLEL_INDEX_QUESTIONS = 4096;
+
+    // Indexes every loaded question (startup only, before the manager is shared)
+    // The search index is the expensive part, so it's built in two parallel passes:
+    // each worker tokenizes a range of questions and routes every term to a shard
+    // by hash, then each worker builds the postings of one shard. No two threads
+    // ever touch the same term, and the shards are spliced together at the end.
+    void BuildIndexes() {
+        ASKME_TRACE_SCOPE("QuestionManager::BuildIndexes");
+        vector<const Question*> all;
+        all.reserve(questions.size());
+        for (const auto& [id, question] : questions) {
+            all.push_back(&question);
+        }
+        const size_t workers = ParallelWork::Workers(all.size(), PARALLEL_INDEX_QUESTIONS);
+        if (workers == 1) {
+            for (const Question* question : all) {
+                IndexQuestion(*question);
+            }
+            return;
+        }
+
+        vector<vector<vector<pair<string, int>>>> routed(workers, vector<vector<pair<string, int>>>(workers));
+        vector<unordered_map<string, unordered_map<int, int>>> shards(workers);
+        ParallelWork::Run(workers, [&](size_t w) {
+            const hash<string> term_hash;
+            for (size_t i = all.size() * w / workers; i < all.size() * (w + 1) / workers; ++i) {
+                const Question& q = *all[i];
+                for (string_view text : {string_view(q.getText()), string_view(q.getAnswer())}) {
+                    for (string& term : Tokenize(text)) {
+                        size_t shard = term_hash(term) % workers;
+                        routed[w][shard].emplace_back(move(term), q.getId());
+                    }
+                }
+            }
+        });
+        ParallelWork::Run(workers + 1, [&](size_t w) {
+            if (w == workers) {
+                // Meanwhile, the ID indexes on this thread
+                for (const Question* q : all) {
+                    question_ids.insert(q->getId());
+                    questions_to_user[q->getToUserId()].insert(q->getId());
+                    questions_from_user[q->getFromUserId()].insert(q->getId());
+                    if (q->getParentId() != -1) {
+                        thread_children[q->getParentId()].insert(q->getId());
+                    }
+                }
+                return;
+            }
+            for (auto& source : routed) {
+                for (auto& [term, question_id] : source[w]) {
+                    ++shards[w][move(term)][question_id];
+                }
+                vector<pair<string, int>>().swap(source[w]);
+            }
+        });
+        for (auto& shard : shards) {
+            search_index.merge(shard);
+        }
+    }
+
+    // Removes a question ID from one index, dropping the bucket once it's empty
+    static void RemoveFromIndex(unordered_map<int, set<int>>& index, int key, int question_id) {
+        auto it = index.find(key);
+        if (it != index.end()) {
+            it->second.erase(question_id);
+            if (it->second.empty()) {
+                index.erase(it);
+            }
+        }
+    }
+
+    // Removes a question from every secondary index
+    void UnindexQuestion(const Question& q) {
+        question_ids.erase(q.getId());
+        UpdateSearchIndex(q, -1);
+        RemoveFromIndex(questions_to_user, q.getToUserId(), q.getId());
+        RemoveFromIndex(questions_from_user, q.getFromUserId(), q.getId());
+        if (q.getParentId() != -1) {
+            RemoveFromIndex(thread_children, q.getParentId(), q.getId());
+        }
+    }
+
+    // Looks up the question IDs stored under a key (empty set if none)
+    static const set<int>& IndexLookup(const unordered_map<int, set<int>>& index, int key) {
+        static const set<int> empty;
+        auto it = index.find(key);
+        return it == index.end() ? empty : it->second;
+    }
+
+    // Erases a question from the store and the indexes
+    void EraseQuestion(int question_id) {
+        auto it = questions.find(question_id);
+        if (it != questions.end()) {
+            UnindexQuestion(it->second);
+            questions.erase(it);
+        }
+    }
+
+    // Flush() for callers that already hold the writer lock
+    bool FlushLocked() {
+        if (!dirty.IsDirty()) {
+            return true;
+        }
+        if (journal_records + pending_records.size() >= compaction_threshold) {
+            return CompactLocked();
+        }
+        if (!file_manager.AppendToJournal(pending_records)) {
+            return false;
+        }
+        journal_records += pending_records.size();
+        pending_records.clear();
+        dirty.MarkClean();
+        return true;
+    }
+
+    // FlushIfDue() for callers that already hold the writer lock
+    bool FlushIfDueLocked() {
+        return dirty.IsDue() ? FlushLocked() : true;
+    }
+
+    // Compact() for callers that already hold the writer lock
+    bool CompactLocked() {
+        if (!file_manager.SaveQuestions(questions, next_question_id)) {
+            return false;
+        }
+        journal_records = 0;
+        pending_records.clear();
+        dirty.MarkClean();
+        return true;
+    }
+
+    // Queues a mutation for the journal instead of rewriting the whole file
+    // Nothing is written here - public operations call FlushIfDueLocked() once they're done,
+    // so a multi-record operation (e.g. a cascading delete) costs a single write
+    void Persist(string record) {
+        pending_records.push_back(move(record));
+        dirty.MarkDirty();
+    }
+
+    // Removes the thread questions of a parent without flushing
+    // Replies to replies are removed too, deepest first
+    void EraseThreadQuestions(int parent_id, const User& current_user, ostream& out) {
+        // Collect the whole conversation (copied, since erasing updates the index)
+        vector<pair<int, int>> replies = CollectThread(parent_id);
+
+        // Delete each thread, children before their parents
+        for (auto it = replies.rbegin(); it != replies.rend(); ++it) {
+            int thread_id = it->first;
+            const Question& reply = questions[thread_id];
+
+            if (reply.getFromUserId() != current_user.getId() && current_user.getRole() == User::REGULAR_USER) {
+                out << "[Skipped] Cannot delete thread question ID " << thread_id << " (Not your question).\n";
+                continue;
+            }
+
+            EraseQuestion(thread_id);
+            out << "[Success] Deleted thread question ID: " << thread_id << "\n";
+            Persist(FileManager::JournalDelete(thread_id));
+        }
+    }
+
+    // Walks the conversation tree below a question using the thread index
+    // Returns: (question ID, depth) pairs in display order - each reply follows its
+    //          parent, siblings in chronological (ID) order; direct replies have depth 1
+    // Note: Iterative, so very long reply chains can't overflow the stack, and each question
+    //       is visited once, so a parent_id cycle in a damaged data file can't loop forever
+    vector<pair<int, int>> CollectThread(int parent_id) const {
+        vector<pair<int, int>> replies;
+        unordered_set<int> visited = {parent_id};
+        vector<pair<int, int>> pending = {{parent_id, 0}};
+        while (!pending.empty()) {
+            auto [id, depth] = pending.back();
+            pending.pop_back();
+            if (depth > 0) {
+                replies.emplace_back(id, depth);
+            }
+
+            const set<int>& children = IndexLookup(thread_children, id);
+            for (auto child = children.rbegin(); child != children.rend(); ++child) {
+                if (visited.insert(*child).second) {
+                    pending.emplace_back(*child, depth + 1);
+                }
+            }
+        }
+        return replies;
+    }
 
     // Helper method to print question details
-    void PrintQuestion(const Question& q, bool is_thread = false) const {
+    // Formats into `out`, which writes to the stream in large chunks
+    // depth: Nesting level of a thread question (replies to replies are indented)
+    void PrintQuestion(const Question& q, bool is_thread, OutputBuffer& out, int depth = 1) const {
+        ASKME_TRACE_SCOPE("QuestionManager::PrintQuestion");
+        const string indent(is_thread ? 2 * (depth - 1) : 0, ' ');
         if (is_thread) {
-            cout << "├─ Thread ";
+            out << indent << "├─ Thread ";
         }
         
-        cout << "Question ID: " << q.getId() << "\n";
+        out << "Question ID: " << q.getId() << '\n';
         
         if (!is_thread) {
-            cout << "To: User ID " << q.getToUserId() << "\n";
+            out << "To: User ID " << q.getToUserId() << '\n';
         }
         
         if (!q.getIsAnonymous() || !is_thread) {
-            cout << "From: " << (q.getIsAnonymous() ? "Anonymous" : "User ID " + to_string(q.getFromUserId())) << "\n";
+            out << indent << "From: ";
+            if (q.getIsAnonymous()) {
+                out << "Anonymous";
+            } else {
+                out << "User ID " << q.getFromUserId();
+            }
+            out << '\n';
         }
         
-        cout << "Question: " << q.getText() << "\n";
-        cout << "Answer: " << (q.isAnswered() ? q.getAnswer() : "Not answered yet") << "\n";
-        cout << (is_thread ? "  " : "") << "───\n";
+        out << indent << "Question: " << q.getText() << '\n';
+        out << indent << "Answer: " << (q.isAnswered() ? string_view(q.getAnswer()) : string_view("Not answered yet")) << '\n';
+        out << (is_thread ? indent + "  " : "") << "───\n";
     }
 
 public:
-    QuestionManager(UserManager& um) : user_manager(um) {
-        questions = file_manager.LoadQuestions();
+    // policy: When queued journal records are written (default: immediately)
+    // compaction_threshold: Number of journal records kept before a snapshot is written
+    QuestionManager(DataStore& store, UserManager& um,
+        const PersistencePolicy& policy = PersistencePolicy::WriteThrough(), size_t compaction_threshold = 1000)
+        : questions(store.GetQuestions()), user_manager(um), file_manager(store.GetFileManager()),
+        journal_records(store.GetQuestionJournalRecords()),
+        next_question_id(store.GetNextQuestionIDCounter()),
+        compaction_threshold(max<size_t>(compaction_threshold, 1)), dirty(policy) {
+        BuildIndexes();
+    }
+
+    // Writes any pending changes before going away
+    ~QuestionManager() {
+        Flush();
+    }
+
+    // Writes all queued journal records now, compacting the journal if it grew too large
+    // Returns: True if nothing was pending or the write succeeded
+    bool Flush() {
+        unique_lock lock(mutex);
+        return FlushLocked();
+    }
+
+    // Flushes only if the persistence policy says the pending records are due
+    bool FlushIfDue() {
+        unique_lock lock(mutex);
+        return FlushIfDueLocked();
+    }
+
+    // Changes when queued journal records are written
+    void SetPersistencePolicy(const PersistencePolicy& policy) {
+        unique_lock lock(mutex);
+        dirty.SetPolicy(policy);
     }
 
-    // Gets the next available question ID
+    // Gets the policy that decides when queued journal records are written
+    PersistencePolicy GetPersistencePolicy() const {
+        shared_lock lock(mutex);
+        return dirty.GetPolicy();
+    }
+
+    // Checks whether a question exists
+    bool QuestionExists(int question_id) const {
+        shared_lock lock(mutex);
+        return questions.count(question_id) != 0;
+    }
+
+    // Retrieves a question by its unique ID
+    // Returns: A copy of the question (other sessions may change the stored one)
+    // Throws: runtime_error if question not found
+    Question GetQuestionByID(int question_id) const {
+        shared_lock lock(mutex);
+        auto it = questions.find(question_id);
+        if (it == questions.end()) {
+            throw runtime_error("Question not found");
+        }
+        return it->second;
+    }
+
+    // Removes a question and its thread questions without permission checks or messages
+    // Used by administrative tools such as batch mode
+    // Returns: Number of questions removed (0 if the question doesn't exist)
+    size_t RemoveQuestion(int question_id) {
+        unique_lock lock(mutex);
+        if (!questions.count(question_id)) {
+            return 0;
+        }
+
+        vector<pair<int, int>> replies = CollectThread(question_id);
+        for (auto it = replies.rbegin(); it != replies.rend(); ++it) {
+            EraseQuestion(it->first);
+            Persist(FileManager::JournalDelete(it->first));
+        }
+        EraseQuestion(question_id);
+        Persist(FileManager::JournalDelete(question_id));
+        FlushIfDueLocked();
+        return replies.size() + 1;
+    }
+
+    // Writes the current state as a new snapshot and clears the journal
+    // Note: Queued journal records are dropped, since the snapshot already contains them
+    bool Compact() {
+        unique_lock lock(mutex);
+        return CompactLocked();
+    }
+
+    // Gets the next available question ID without reserving it
     int GetNextQuestionID() const {
-        if (questions.empty()) return 1;
-        return max_element(questions.begin(), questions.end(),
-            [](const auto& a, const auto& b) {
-                return a.first < b.first;
-            })->first + 1;
+        shared_lock lock(mutex);
+        return next_question_id;
+    }
+
+    // Reserves a fresh question ID, so repeated calls never collide
+    int AllocateQuestionID() {
+        unique_lock lock(mutex);
+        return next_question_id++;
     }
 
     // Adds a new question to the system
+    // Fails if the recipient is unknown or refuses anonymous questions, or the parent question doesn't exist
     bool AddQuestion(const Question& question) {
-        if (questions.count(question.getId())) {
-            cerr << "Error: Question ID " << question.getId() << " already exists\n";
-            return false;
-        }
-        
+        // Check the recipient before locking, so this lock is never held while waiting on UserManager's
         try {
-            const User& recipient = user_manager.GetUserByID(question.getToUserId());
+            const User recipient = user_manager.GetUserByID(question.getToUserId());
             if (question.getIsAnonymous() && !recipient.getAllowAnonymousQuestions()) {
                 cerr << "Error: User " << recipient.getName() << " doesn't accept anonymous questions\n";
                 return false;
@@ -597,20 +2381,62 @@ public:
             cerr << "Error: Recipient user not found\n";
             return false;
         }
+
+        unique_lock lock(mutex);
+        if (questions.count(question.getId())) {
+            cerr << "Error: Question ID " << question.getId() << " already exists\n";
+            return false;
+        }
+        // Checked under the lock, so a concurrent delete can't leave an orphaned thread question
+        if (question.getParentId() != -1 && !questions.count(question.getParentId())) {
+            cerr << "Error: Parent question ID " << question.getParentId() << " doesn't exist\n";
+            return false;
+        }
         
         questions[question.getId()] = question;
-        return file_manager.SaveQuestions(questions);
+        IndexQuestion(question);
+        next_question_id = max(next_question_id, question.getId() + 1);
+        Persist(FileManager::JournalAdd(question));
+        return FlushIfDueLocked();
     }
     
     // Updates an existing question
     bool UpdateQuestion(const Question& question) {
+        unique_lock lock(mutex);
         if (!questions.count(question.getId())) {
             cerr << "Error: Question ID " << question.getId() << " not found\n";
             return false;
         }
         
-        questions[question.getId()] = question;
-        return file_manager.SaveQuestions(questions);
+        Question& stored = questions[question.getId()];
+        UnindexQuestion(stored);
+        stored = question;
+        IndexQuestion(stored);
+        Persist(FileManager::JournalUpdate(question));
+        return FlushIfDueLocked();
+    }
+
+    // Outcome of SetAnswer()
+    enum AnswerStatus { ANSWERED, QUESTION_NOT_FOUND, NOT_RECIPIENT, SAVE_FAILED };
+
+    // Replaces the answer of a question in one locked step, so concurrent changes to it aren't lost
+    // recipient_id: Only this user may answer (-1 = anyone, for administrative tools)
+    AnswerStatus SetAnswer(int question_id, const string& answer, int recipient_id = -1) {
+        unique_lock lock(mutex);
+        auto it = questions.find(question_id);
+        if (it == questions.end()) {
+            return QUESTION_NOT_FOUND;
+        }
+        if (recipient_id != -1 && it->second.getToUserId() != recipient_id) {
+            return NOT_RECIPIENT;
+        }
+
+        Question& stored = it->second;
+        UnindexQuestion(stored);
+        stored.setAnswer(answer);
+        IndexQuestion(stored);
+        Persist(FileManager::JournalUpdate(stored));
+        return FlushIfDueLocked() ? ANSWERED : SAVE_FAILED;
     }
 
     // Interactive question asking flow
@@ -627,7 +2453,7 @@ public:
         }
 
         try {
-            const User& recipient = user_manager.GetUserByID(to_user_id);
+            const User recipient = user_manager.GetUserByID(to_user_id);
             
             cout << "Is this a follow-up question? (y/n): ";
             char response;
@@ -636,7 +2462,7 @@ public:
             int parent_id = -1;
             if (tolower(response) == 'y') {
                 cout << "Enter parent question ID: ";
-                if (!(cin >> parent_id) || !questions.count(parent_id)) {
+                if (!(cin >> parent_id) || !QuestionExists(parent_id)) {
                     cerr << "Invalid parent question ID. Starting new question thread.\n";
                     parent_id = -1;
                 }
@@ -655,7 +2481,7 @@ public:
             }
 
             Question question(
-                GetNextQuestionID(),
+                AllocateQuestionID(),
                 parent_id,
                 current_user.getId(),
                 to_user_id,
@@ -687,13 +2513,14 @@ public:
             return;
         }
 
-        auto it = questions.find(question_id);
-        if (it == questions.end()) {
+        Question question; // Shown while the answer is typed; the answer itself goes through SetAnswer()
+        try {
+            question = GetQuestionByID(question_id);
+        } catch (const runtime_error&) {
             cerr << "Error: Question ID " << question_id << " doesn't exist\n";
             return;
         }
 
-        Question& question = it->second;
         if (question.getToUserId() != current_user_id) {
             cerr << "Error: You can only answer questions addressed to you\n";
             return;
@@ -720,43 +2547,73 @@ public:
         cin.ignore();
         getline(cin, answer);
 
-        question.setAnswer(answer);
-        if (UpdateQuestion(question)) {
-            cout << "\n✓ Answer submitted successfully!\n";
+        switch (SetAnswer(question_id, answer, current_user_id)) {
+            case ANSWERED:
+                cout << "\n✓ Answer submitted successfully!\n";
+                break;
+            case QUESTION_NOT_FOUND:
+                cerr << "Error: Question ID " << question_id << " was deleted meanwhile\n";
+                break;
+            case NOT_RECIPIENT:
+                cerr << "Error: You can only answer questions addressed to you\n";
+                break;
+            case SAVE_FAILED:
+                break; // FileManager already reported it
         }
     }
 
     // Prints questions addressed to a specific user
-    void PrintQuestionsToUser(int user_id) const {
-        cout << "\n─── Questions To You ───\n";
-        bool found = false;
+    void PrintQuestionsToUser(int user_id, ostream& stream = cout) const {
+        ASKME_TRACE_SCOPE("QuestionManager::PrintQuestionsToUser");
+        shared_lock lock(mutex);
+        OutputBuffer out(stream);
+        out << "\n─── Questions To You ───\n";
+        const set<int>& ids = IndexLookup(questions_to_user, user_id);
+        ASKME_TRACE_COUNT("Questions scanned per view", ids.size());
         
-        for (const auto& [id, question] : questions) {
-            if (question.getToUserId() == user_id) {
-                found = true;
-                PrintQuestion(question, question.getParentId() != -1);
-            }
+        for (int id : ids) {
+            const Question& question = questions.at(id);
+            PrintQuestion(question, question.getParentId() != -1, out);
         }
         
-        if (!found) {
-            cout << "No questions found addressed to you.\n";
+        if (ids.empty()) {
+            out << "No questions found addressed to you.\n";
         }
     }
 
     // Prints questions asked by a specific user
-    void PrintQuestionsFromUser(int user_id) const {
-        cout << "\n─── Questions From You ───\n";
-        bool found = false;
+    void PrintQuestionsFromUser(int user_id, ostream& stream = cout) const {
+        ASKME_TRACE_SCOPE("QuestionManager::PrintQuestionsFromUser");
+        shared_lock lock(mutex);
+        OutputBuffer out(stream);
+        out << "\n─── Questions From You ───\n";
+        const set<int>& ids = IndexLookup(questions_from_user, user_id);
+        ASKME_TRACE_COUNT("Questions scanned per view", ids.size());
         
-        for (const auto& [id, question] : questions) {
-            if (question.getFromUserId() == user_id) {
-                found = true;
-                PrintQuestion(question, question.getParentId() != -1);
-            }
+        for (int id : ids) {
+            const Question& question = questions.at(id);
+            PrintQuestion(question, question.getParentId() != -1, out);
         }
         
-        if (!found) {
-            cout << "You haven't asked any questions yet.\n";
+        if (ids.empty()) {
+            out << "You haven't asked any questions yet.\n";
+        }
+    }
+
+    // Prints the thread questions of an existing parent question
+    // Shows the whole conversation: replies to replies are nested under their parent
+    void PrintThreadQuestions(int parent_id, ostream& stream = cout) const {
+        shared_lock lock(mutex);
+        OutputBuffer out(stream);
+        vector<pair<int, int>> replies = CollectThread(parent_id);
+        ASKME_TRACE_COUNT("Questions scanned per view", replies.size());
+        out << "\nThreads for question ID " << parent_id << ":\n";
+        for (const auto& [id, depth] : replies) {
+            PrintQuestion(questions.at(id), true, out, depth); // true indicates it's a thread
+        }
+
+        if (replies.empty()) {
+            out << "No thread questions found for this parent question.\n";
         }
     }
 
@@ -772,105 +2629,691 @@ public:
             return;
         }
 
-        if (!questions.count(parent_id)) {
+        if (!QuestionExists(parent_id)) {
             cerr << "Error: Parent question ID " << parent_id << " doesn't exist\n";
             return;
         }
 
-        bool found = false;
-        cout << "\nThreads for question ID " << parent_id << ":\n";
-        for (const auto& [id, question] : questions) {
-            if (question.getParentId() == parent_id) {
-                found = true;
-                PrintQuestion(question, true); // true indicates it's a thread
+        PrintThreadQuestions(parent_id);
+    }
+
+    // Prints questions in the system in ID order, one page at a time (admin only)
+    // after_id: Only questions with a larger ID are shown (0 starts from the beginning)
+    // page_size: Maximum number of questions to show (0 shows the whole feed)
+    // Returns: ID of the last question shown if more remain, -1 once the feed is done
+    int GetFeed(const User& current_user, int after_id = 0, size_t page_size = 0, ostream& stream = cout) const {
+        if (current_user.getRole() != User::ADMIN) {
+            stream << "\n─── System Questions Feed ───\n";
+            stream << "⛔ Access denied: This feature is only available for administrators.\n";
+            return -1;
+        }
+
+        ASKME_TRACE_SCOPE("QuestionManager::GetFeed");
+        shared_lock lock(mutex);
+        OutputBuffer out(stream);
+        if (after_id == 0) {
+            out << "\n─── System Questions Feed ───\n";
+            if (questions.empty()) {
+                out << "No questions in the system yet.\n";
+                return -1;
             }
+            out << "Total questions: " << questions.size() << "\n\n";
         }
 
-        if (!found) {
-            cout << "No thread questions found for this parent question.\n";
+        size_t shown = 0;
+        for (auto it = question_ids.upper_bound(after_id); it != question_ids.end(); ++it) {
+            if (page_size != 0 && shown == page_size) {
+                ASKME_TRACE_COUNT("Questions scanned per view", shown);
+                return after_id; // More questions remain after this page
+            }
+            const Question& question = questions.at(*it);
+            PrintQuestion(question, question.getParentId() != -1, out);
+            after_id = *it;
+            ++shown;
         }
+        ASKME_TRACE_COUNT("Questions scanned per view", shown);
+        return -1;
     }
 
-    // Prints all questions in the system (admin only)
-    void GetFeed(const User& current_user) {
-        cout << "\n─── System Questions Feed ───\n";
-
-        if (current_user.getRole() != User::ADMIN) {
-            cerr << "⛔ Access denied: This feature is only available for administrators.\n";
-            return;
+    // Ranks questions by TF-IDF relevance to a free-text query
+    // Only the postings of the query terms are visited, never the whole store
+    // user_id: Restricts results to questions to or from this user (-1 = every question)
+    // limit: Maximum number of results (0 = all matches)
+    // Returns: (question ID, score) pairs, best match first
+    vector<pair<int, double>> Search(string_view query, int user_id = -1, size_t limit = 10) const {
+        ASKME_TRACE_SCOPE("QuestionManager::Search");
+        shared_lock lock(mutex);
+        vector<string> terms = Tokenize(query);
+        sort(terms.begin(), terms.end());
+        terms.erase(unique(terms.begin(), terms.end()), terms.end());
+
+        unordered_map<int, double> scores;
+        for (const string& term : terms) {
+            auto postings = search_index.find(term);
+            if (postings == search_index.end()) {
+                continue;
+            }
+            double idf = log(1.0 + double(questions.size()) / postings->second.size());
+            ASKME_TRACE_COUNT("Search postings scanned", postings->second.size());
+            for (const auto& [id, count] : postings->second) {
+                if (user_id != -1) {
+                    const Question& q = questions.at(id);
+                    if (q.getToUserId() != user_id && q.getFromUserId() != user_id) {
+                        continue;
+                    }
+                }
+                scores[id] += (1.0 + log(double(count))) * idf;
+            }
         }
 
-        if (questions.empty()) {
-            cout << "No questions in the system yet.\n";
-            return;
+        vector<pair<int, double>> results(scores.begin(), scores.end());
+        auto better = [](const pair<int, double>& a, const pair<int, double>& b) {
+            return a.second != b.second ? a.second > b.second : a.first < b.first;
+        };
+        if (limit != 0 && results.size() > limit) {
+            partial_sort(results.begin(), results.begin() + limit, results.end(), better);
+            results.resize(limit);
+        } else {
+            sort(results.begin(), results.end(), better);
         }
+        return results;
+    }
 
-        cout << "Total questions: " << questions.size() << "\n\n";
-        for (const auto& [id, question] : questions) {
-            PrintQuestion(question, question.getParentId() != -1);
+    // Prints the best matches for a query
+    // Admins search every question, regular users only questions to or from them
+    void PrintSearchResults(string_view query, const User& current_user, size_t limit = 10, ostream& stream = cout) const {
+        vector<pair<int, double>> results =
+            Search(query, current_user.getRole() == User::ADMIN ? -1 : current_user.getId(), limit);
+
+        shared_lock lock(mutex);
+        OutputBuffer out(stream);
+        out << "\n─── Search Results ───\n";
+        size_t shown = 0;
+        for (const auto& [id, score] : results) {
+            auto it = questions.find(id);
+            if (it != questions.end()) { // May have been deleted since the search
+                PrintQuestion(it->second, it->second.getParentId() != -1, out);
+                ++shown;
+            }
+        }
+        if (shown == 0) {
+            out << "No questions match your search.\n";
         }
     }
 
+    // Interactive search flow
+    void SearchQuestions(const User& current_user) {
+        cout << "\n─── Search Questions ───\n";
+        cout << "Enter search words: ";
+        string query;
+        cin >> ws;
+        getline(cin, query);
+        PrintSearchResults(query, current_user);
+    }
+
     // Deletes a question and all its threads
-    bool DeleteQuestion(int question_id, const User& current_user) {
+    // out: Receives the result messages
+    bool DeleteQuestion(int question_id, const User& current_user, ostream& out = cout) {
+        unique_lock lock(mutex);
         if (!questions.count(question_id)) {
-            cerr << "[Error] Question ID " << question_id << " doesn't exist.\n";
+            out << "[Error] Question ID " << question_id << " doesn't exist.\n";
             return false;
         }
 
         const Question& question = questions[question_id];
 
         if (question.getFromUserId() != current_user.getId() && current_user.getRole() == User::REGULAR_USER) {
-            cout << "[Access Denied] You can only delete questions you asked.\n";
+            out << "[Access Denied] You can only delete questions you asked.\n";
             return false;
         }
 
         // Delete thread questions first
-        DeleteThreadQuestions(question_id, current_user);
+        EraseThreadQuestions(question_id, current_user, out);
 
         // Delete the main question
-        questions.erase(question_id);
-        cout << "[Success] Deleted question ID: " << question_id << "\n";
+        EraseQuestion(question_id);
+        out << "[Success] Deleted question ID: " << question_id << "\n";
 
-        return file_manager.SaveQuestions(questions);
+        Persist(FileManager::JournalDelete(question_id));
+        return FlushIfDueLocked();
     }
 
     // Deletes all thread questions for a parent question
-    void DeleteThreadQuestions(int parent_id, const User& current_user) {
-        vector<int> threads_to_delete;
+    void DeleteThreadQuestions(int parent_id, const User& current_user, ostream& out = cout) {
+        unique_lock lock(mutex);
+        EraseThreadQuestions(parent_id, current_user, out);
+        FlushIfDueLocked();
+    }
 
-        // Collect all thread IDs
-        for (const auto& [id, question] : questions) {
-            if (question.getParentId() == parent_id) {
-                threads_to_delete.push_back(id);
+};
+
+// Runs scripted commands straight against the managers, without interactive prompts
+// Used for bulk imports and load tests; everything is written in a single flush at the end
+// Script format: one command per line, blank lines and lines starting with '#' are ignored
+//   adduser <allow_anonymous 0|1> <username> <password> <email> <full name...>
+//   ask <from_user_id> <to_user_id> <parent_id|-1> <anonymous 0|1> <text...>
+//   answer <question_id> <answer...>
+//   delete <question_id>
+//   import-users <file>        (users.txt format)
+//   import-questions <file>    (questions.txt format)
+class BatchProcessor {
+public:
+    // Summary of a batch run
+    struct Report {
+        size_t commands = 0;   // Commands read (imports count one per record)
+        size_t applied = 0;    // Commands that succeeded
+        double seconds = 0;    // Wall time, including the final flush
+    };
+
+private:
+    UserManager& user_manager;
+    QuestionManager& question_manager;
+
+    // Reads the rest of a command line (skipping leading spaces)
+    static string Rest(istringstream& in) {
+        string text;
+        getline(in >> ws, text);
+        return text;
+    }
+
+    // Adds every user from a CSV file
+    void ImportUsers(const string& path, Report& report) {
+        CsvReader reader;
+        if (!reader.Open(path)) {
+            throw runtime_error("Unable to open file: " + path);
+        }
+        int next_id = 0; // The file's high-water mark; AddUser() raises ours past every imported ID
+        while (reader.Next()) {
+            if (FileManager::ReadNextIdHeader(reader.Fields(), next_id)) {
+                continue;
+            }
+            ++report.commands;
+            User user;
+            if (FileManager::ParseUser(reader.Fields(), reader.Line(), user) && user_manager.AddUser(user)) {
+                ++report.applied;
+            }
+        }
+    }
+
+    // Adds every question from a CSV file
+    // SaveQuestions() writes in hash order, so replies may come before their parents; questions
+    // are added in ID order instead, and a reply always has a higher ID than its parent
+    void ImportQuestions(const string& path, Report& report) {
+        CsvReader reader;
+        if (!reader.Open(path)) {
+            throw runtime_error("Unable to open file: " + path);
+        }
+        int next_id = 0;
+        vector<Question> questions;
+        while (reader.Next()) {
+            if (FileManager::ReadNextIdHeader(reader.Fields(), next_id)) {
+                continue;
+            }
+            ++report.commands;
+            Question question;
+            if (FileManager::ParseQuestion(reader.Fields(), 0, reader.Line(), question)) {
+                questions.push_back(question);
+            }
+        }
+        // Stable, so of two records with the same ID the first in the file still wins
+        stable_sort(questions.begin(), questions.end(), [](const Question& a, const Question& b) {
+            return a.getId() < b.getId();
+        });
+        for (const Question& question : questions) {
+            if (question_manager.AddQuestion(question)) {
+                ++report.applied;
+            }
+        }
+    }
+
+    // Applies one command
+    // Returns: True if it succeeded
+    // Throws: runtime_error for malformed commands or unknown IDs
+    bool Apply(const string& command, istringstream& in, Report& report) {
+        if (command == "adduser") {
+            int allow_anonymous;
+            string username, password, email;
+            if (!(in >> allow_anonymous >> username >> password >> email)) {
+                throw runtime_error("Usage: adduser <allow_anonymous> <username> <password> <email> <name>");
+            }
+            User user(user_manager.AllocateUserID(), Rest(in), "", username, email, allow_anonymous == 1);
+            user.setPassword(password);
+            return user_manager.AddUser(user);
+        }
+        if (command == "ask") {
+            int from_user_id, to_user_id, parent_id, anonymous;
+            if (!(in >> from_user_id >> to_user_id >> parent_id >> anonymous)) {
+                throw runtime_error("Usage: ask <from_user_id> <to_user_id> <parent_id> <anonymous> <text>");
+            }
+            user_manager.GetUserByID(from_user_id); // Throws if the asker doesn't exist
+            user_manager.GetUserByID(to_user_id);   // ...or the recipient
+            if (parent_id != -1) {
+                question_manager.GetQuestionByID(parent_id); // Throws if the parent doesn't exist
+            }
+            Question question(question_manager.AllocateQuestionID(), parent_id, from_user_id, to_user_id,
+                anonymous == 1, Rest(in));
+            return question_manager.AddQuestion(question);
+        }
+        if (command == "answer") {
+            int question_id;
+            if (!(in >> question_id)) {
+                throw runtime_error("Usage: answer <question_id> <answer>");
+            }
+            switch (question_manager.SetAnswer(question_id, Rest(in))) {
+                case QuestionManager::QUESTION_NOT_FOUND:
+                    throw runtime_error("Question not found");
+                case QuestionManager::ANSWERED:
+                    return true;
+                default:
+                    return false;
+            }
+        }
+        if (command == "delete") {
+            int question_id;
+            if (!(in >> question_id)) {
+                throw runtime_error("Usage: delete <question_id>");
+            }
+            if (question_manager.RemoveQuestion(question_id) == 0) {
+                throw runtime_error("Question not found");
+            }
+            return true;
+        }
+        if (command == "import-users" || command == "import-questions") {
+            --report.commands; // Each imported record is counted instead
+            string path = Rest(in);
+            if (command == "import-users") {
+                ImportUsers(path, report);
+            } else {
+                ImportQuestions(path, report);
+            }
+            return false; // Records were counted individually
+        }
+        throw runtime_error("Unknown command: " + command);
+    }
+
+public:
+    BatchProcessor(UserManager& um, QuestionManager& qm) : user_manager(um), question_manager(qm) {}
+
+    // Applies every command in a script, then writes all changes at once
+    // in: The script to run
+    // log: Receives error messages and the throughput summary
+    // Returns: Counts and timing for the run
+    Report Run(istream& in, ostream& log) {
+        const PersistencePolicy user_policy = user_manager.GetPersistencePolicy();
+        const PersistencePolicy question_policy = question_manager.GetPersistencePolicy();
+        user_manager.SetPersistencePolicy(PersistencePolicy::Manual());
+        question_manager.SetPersistencePolicy(PersistencePolicy::Manual());
+
+        Report report;
+        auto start = chrono::steady_clock::now();
+        string line;
+        size_t line_number = 0;
+        while (getline(in, line)) {
+            ++line_number;
+            istringstream command_line(line);
+            string command;
+            if (!(command_line >> command) || command[0] == '#') {
+                continue;
+            }
+
+            ++report.commands;
+            try {
+                if (Apply(command, command_line, report)) {
+                    ++report.applied;
+                }
+            } catch (const exception& e) {
+                log << "Line " << line_number << ": " << e.what() << "\n";
+            }
+        }
+
+        bool flushed = user_manager.Flush() && question_manager.Flush();
+        report.seconds = chrono::duration<double>(chrono::steady_clock::now() - start).count();
+        user_manager.SetPersistencePolicy(user_policy);
+        question_manager.SetPersistencePolicy(question_policy);
+
+        log << "Applied " << report.applied << " of " << report.commands << " commands in "
+            << fixed << setprecision(3) << report.seconds << "s";
+        if (report.seconds > 0) {
+            log << " (" << static_cast<long long>(report.applied / report.seconds) << " ops/sec)";
+        }
+        log << (flushed ? "" : " - WARNING: changes could not be saved") << "\n";
+        return report;
+    }
+};
+
+// Runs one client's commands against the shared managers
+// Every connected client gets its own session (and login state); the managers are shared
+// Protocol: one command per line, each reply ends with a line holding a single "."
+//   login <user_id> <password>            logout
+//   inbox                                 outbox
+//   thread <question_id>                  ask <to_user_id> <parent_id|-1> <anonymous 0|1> <text...>
+//   answer <question_id> <answer...>      delete <question_id>
+//   search <words...>                     help
+//   quit
+//   Admin only: feed [after_id] [page_size], users, deleteuser <user_id>, shutdown
+class ClientSession {
+public:
+    enum Status { OPEN, CLOSED, SHUTDOWN }; // What the connection should do after a command
+
+private:
+    UserManager& user_manager;
+    QuestionManager& question_manager;
+    AuthService auth_service; // This client's login state
+
+    // Reads the rest of a command line (skipping leading spaces)
+    static string Rest(istringstream& in) {
+        string text;
+        getline(in >> ws, text);
+        return text;
+    }
+
+    // Commands that need a logged-in user
+    Status HandleUserCommand(const string& command, istringstream& in, ostream& out) {
+        const User user = auth_service.GetCurrentUser();
+        const bool is_admin = user.getRole() == User::ADMIN;
+        int id;
+
+        if (command == "logout") {
+            auth_service.Logout(out);
+        } else if (command == "inbox") {
+            question_manager.PrintQuestionsToUser(user.getId(), out);
+        } else if (command == "outbox") {
+            question_manager.PrintQuestionsFromUser(user.getId(), out);
+        } else if (command == "thread") {
+            if (!(in >> id)) {
+                out << "Usage: thread <question_id>\n";
+            } else if (!question_manager.QuestionExists(id)) {
+                out << "Error: Parent question ID " << id << " doesn't exist\n";
+            } else {
+                question_manager.PrintThreadQuestions(id, out);
+            }
+        } else if (command == "ask") {
+            int to_user_id, parent_id, anonymous;
+            if (!(in >> to_user_id >> parent_id >> anonymous)) {
+                out << "Usage: ask <to_user_id> <parent_id|-1> <anonymous 0|1> <text>\n";
+            } else if (parent_id != -1 && !question_manager.QuestionExists(parent_id)) {
+                out << "Error: Parent question ID " << parent_id << " doesn't exist\n";
+            } else {
+                Question question(question_manager.AllocateQuestionID(), parent_id, user.getId(), to_user_id,
+                    anonymous == 1, Rest(in));
+                if (question_manager.AddQuestion(question)) {
+                    out << "Question submitted, ID: " << question.getId() << "\n";
+                } else {
+                    out << "Error: Question was not added (unknown recipient, deleted parent"
+                        << " or anonymous questions not allowed)\n";
+                }
+            }
+        } else if (command == "answer") {
+            if (!(in >> id)) {
+                out << "Usage: answer <question_id> <answer>\n";
+                return OPEN;
+            }
+            switch (question_manager.SetAnswer(id, Rest(in), user.getId())) {
+                case QuestionManager::ANSWERED:
+                    out << "Answer submitted\n";
+                    break;
+                case QuestionManager::QUESTION_NOT_FOUND:
+                    out << "Error: Question ID " << id << " doesn't exist\n";
+                    break;
+                case QuestionManager::NOT_RECIPIENT:
+                    out << "Error: You can only answer questions addressed to you\n";
+                    break;
+                case QuestionManager::SAVE_FAILED:
+                    out << "Error: The answer could not be saved\n";
+                    break;
+            }
+        } else if (command == "delete") {
+            if (!(in >> id)) {
+                out << "Usage: delete <question_id>\n";
+            } else {
+                question_manager.DeleteQuestion(id, user, out);
+            }
+        } else if (command == "search") {
+            question_manager.PrintSearchResults(Rest(in), user, 10, out);
+        } else if (command == "feed") {
+            int after_id = 0;
+            size_t page_size = 0;
+            in >> after_id >> page_size;
+            int last_shown = question_manager.GetFeed(user, after_id, page_size, out);
+            if (last_shown != -1) {
+                out << "More: feed " << last_shown << " " << page_size << "\n";
+            }
+        } else if (!is_admin && (command == "users" || command == "deleteuser" || command == "shutdown")) {
+            out << "⛔ Access denied: This feature is only available for administrators.\n";
+        } else if (command == "users") {
+            user_manager.ListSystemUsers(out);
+        } else if (command == "deleteuser") {
+            if (!(in >> id) || !user_manager.DeleteUser(id, out)) {
+                out << "Error: No such user\n";
+            }
+        } else if (command == "shutdown") {
+            out << "Server shutting down\n";
+            return SHUTDOWN;
+        } else {
+            out << "Unknown command: " << command << " (type help)\n";
+        }
+        return OPEN;
+    }
+
+public:
+    ClientSession(UserManager& um, QuestionManager& qm) : user_manager(um), question_manager(qm), auth_service(um) {}
+
+    // Runs one command line, writing the reply to `out`
+    // Returns: Whether the connection stays open
+    Status Handle(const string& line, ostream& out) {
+        istringstream in(line);
+        string command;
+        if (!(in >> command)) {
+            return OPEN;
+        }
+
+        if (command == "quit") {
+            out << "Goodbye!\n";
+            return CLOSED;
+        }
+        if (command == "help") {
+            out << "Commands: login <id> <password>, logout, inbox, outbox, thread <id>,\n"
+                << "  ask <to_id> <parent_id|-1> <anonymous 0|1> <text>, answer <id> <text>, delete <id>,\n"
+                << "  search <words>, feed [after_id] [page_size], users, deleteuser <id>, shutdown, quit\n";
+            return OPEN;
+        }
+        if (command == "login") {
+            int user_id;
+            string password;
+            if (!(in >> user_id >> password)) {
+                out << "Usage: login <user_id> <password>\n";
+            } else if (auth_service.Login(user_id, password)) {
+                out << "Login successful! Welcome, " << auth_service.GetCurrentUser().getName() << ".\n";
+            } else {
+                out << "Invalid information - Please check your ID and password and try again...\n";
             }
+            return OPEN;
         }
+        if (!auth_service.IsLoggedIn()) {
+            out << "Please login first\n";
+            return OPEN;
+        }
+        return HandleUserCommand(command, in, out);
+    }
+};
+
+#ifdef ASKME_HAS_SERVER
+// Serves ClientSession's line protocol to many clients at once over TCP
+// Each connection runs on its own thread; a background thread writes
+// write-behind changes once the persistence policy says they're due
+class AskMeServer {
+private:
+    // A client connection and the thread serving it
+    struct Connection {
+        int fd;
+        thread worker;
+        atomic<bool> done{false}; // Set by the worker once the client is gone
+
+        explicit Connection(int fd) : fd(fd) {}
+    };
+
+    UserManager& user_manager;
+    QuestionManager& question_manager;
+    atomic<bool> running{false};
+    list<Connection> connections; // Only touched by the thread in Run()
 
-        // Delete each thread
-        for (int thread_id : threads_to_delete) {
-            const Question& thread = questions[thread_id];
+    // Writes the whole buffer, retrying short writes
+    static bool SendAll(int fd, string_view data) {
+        while (!data.empty()) {
+            ssize_t sent = send(fd, data.data(), data.size(), 0);
+            if (sent < 0 && errno == EINTR) {
+                continue;
+            }
+            if (sent <= 0) {
+                return false;
+            }
+            data.remove_prefix(static_cast<size_t>(sent));
+        }
+        return true;
+    }
 
-            if (thread.getFromUserId() != current_user.getId() && current_user.getRole() == User::REGULAR_USER) {
-                cout << "[Skipped] Cannot delete thread question ID " << thread_id << " (Not your question).\n";
+    // Reads command lines from one client until it quits or the server stops
+    // Replies are rendered into memory first, so no lock is held while the socket is written
+    void Serve(Connection& connection) {
+        ClientSession session(user_manager, question_manager);
+        string pending;
+        char buffer[4096];
+        bool open = SendAll(connection.fd, "AskMe server - type help for the command list\n.\n");
+        while (open && running) {
+            ssize_t received = recv(connection.fd, buffer, sizeof(buffer), 0);
+            if (received < 0 && errno == EINTR) {
                 continue;
             }
+            if (received <= 0) {
+                break; // Client disconnected, or the server is shutting the socket down
+            }
+            pending.append(buffer, static_cast<size_t>(received));
+
+            size_t start = 0, end;
+            while (open && (end = pending.find('\n', start)) != string::npos) {
+                string line = pending.substr(start, end - start);
+                start = end + 1;
+                if (!line.empty() && line.back() == '\r') {
+                    line.pop_back();
+                }
+
+                ostringstream reply;
+                ClientSession::Status status = session.Handle(line, reply);
+                reply << ".\n";
+                open = SendAll(connection.fd, reply.str()) && status == ClientSession::OPEN;
+                if (status == ClientSession::SHUTDOWN) {
+                    running = false;
+                }
+            }
+            pending.erase(0, start);
+        }
+        connection.done = true;
+    }
+
+    // Joins the threads of clients that already disconnected
+    void ReapFinished() {
+        for (auto it = connections.begin(); it != connections.end();) {
+            if (it->done) {
+                it->worker.join();
+                close(it->fd);
+                it = connections.erase(it);
+            } else {
+                ++it;
+            }
+        }
+    }
+
+public:
+    AskMeServer(UserManager& um, QuestionManager& qm) : user_manager(um), question_manager(qm) {}
+
+    // Accepts clients until an admin sends "shutdown" or Stop() is called
+    // port: TCP port to listen on
+    // listen_address: IPv4 address to bind; passwords travel in plain text, so only
+    //                 widen it past loopback on a trusted network
+    // log: Receives start/stop messages
+    // Returns: True if the server ran and every pending change was written at the end
+    bool Run(uint16_t port, ostream& log, const string& listen_address = "127.0.0.1") {
+        signal(SIGPIPE, SIG_IGN); // A vanished client must not kill the server
+
+        int listen_fd = socket(AF_INET, SOCK_STREAM, 0);
+        if (listen_fd < 0) {
+            log << "Unable to create socket: " << strerror(errno) << "\n";
+            return false;
+        }
+        int reuse = 1;
+        setsockopt(listen_fd, SOL_SOCKET, SO_REUSEADDR, &reuse, sizeof(reuse));
+
+        sockaddr_in address{};
+        address.sin_family = AF_INET;
+        address.sin_port = htons(port);
+        if (inet_pton(AF_INET, listen_address.c_str(), &address.sin_addr) != 1) {
+            log << "Invalid listen address: " << listen_address << "\n";
+            close(listen_fd);
+            return false;
+        }
+        if (bind(listen_fd, reinterpret_cast<sockaddr*>(&address), sizeof(address)) < 0 ||
+            listen(listen_fd, SOMAXCONN) < 0) {
+            log << "Unable to listen on port " << port << ": " << strerror(errno) << "\n";
+            close(listen_fd);
+            return false;
+        }
+
+        running = true;
+        thread flusher([this] {
+            while (running) {
+                this_thread::sleep_for(chrono::milliseconds(100));
+                user_manager.FlushIfDue();
+                question_manager.FlushIfDue();
+            }
+        });
+        log << "AskMe server listening on " << listen_address << ":" << port << endl;
 
-            questions.erase(thread_id);
-            cout << "[Success] Deleted thread question ID: " << thread_id << "\n";
+        while (running) {
+            // Poll instead of blocking in accept(), so a shutdown is noticed promptly
+            pollfd listener{listen_fd, POLLIN, 0};
+            if (poll(&listener, 1, 200) <= 0) {
+                continue;
+            }
+            int client_fd = accept(listen_fd, nullptr, nullptr);
+            if (client_fd < 0) {
+                continue;
+            }
+            ReapFinished();
+            Connection& connection = connections.emplace_back(client_fd);
+            connection.worker = thread(&AskMeServer::Serve, this, ref(connection));
         }
+        close(listen_fd);
 
-        if (!threads_to_delete.empty()) {
-            file_manager.SaveQuestions(questions);
+        // Wake every worker blocked in recv(), then wait for them
+        for (Connection& connection : connections) {
+            shutdown(connection.fd, SHUT_RDWR);
+        }
+        for (Connection& connection : connections) {
+            connection.worker.join();
+            close(connection.fd);
         }
+        connections.clear();
+        flusher.join();
+
+        bool flushed = user_manager.Flush() && question_manager.Flush();
+        log << "AskMe server stopped" << (flushed ? "" : " - WARNING: changes could not be saved") << endl;
+        return flushed;
     }
 
+    // Asks Run() to stop accepting clients and return
+    void Stop() {
+        running = false;
+    }
 };
+#endif
 
 class AskMeSystem {
 private:
-    AuthService auth_service;
+    DataStore store;
     UserManager user_manager;
+    AuthService auth_service;
     QuestionManager question_manager;
+    size_t feed_page_size = 20; // Questions per feed page (0 = whole feed at once)
 
     void PrintHeader(const string& title) {
         cout << "\n┌─────────────────────────────────────────────────────┐\n";
@@ -917,8 +3360,10 @@ private:
         PrintMenuOption(5, "Delete My Question");
         PrintMenuOption(6, "View Thread Questions");
         PrintMenuOption(7, "Logout");
+        // Options added later go after Logout, so existing numbers (and scripted input) keep working
+        PrintMenuOption(8, "Search Questions");
         PrintFooter();
-        cout << "> Select an option [1-7]: ";
+        cout << "> Select an option [1-8]: ";
     }
     
     // Administrator menu
@@ -945,20 +3390,73 @@ private:
         PrintDivider();
         PrintMenuOption(5, "View Thread Questions");
         PrintMenuOption(6, "Logout");
+        // Options added later go after Logout, so existing numbers (and scripted input) keep working
+        PrintMenuOption(7, "Search Questions");
+        PrintMenuOption(8, "Trace Summary");
         
         PrintFooter();
-        cout << "> Select an option [1-6]: ";
+        cout << "> Select an option [1-8]: ";
     }
 
 public:
-    AskMeSystem() : auth_service(user_manager), question_manager(user_manager) {}
+    // file_manager: Where the data lives
+    // policy: How eagerly changes are written; pending changes are always
+    //         flushed at logout and exit
+    AskMeSystem(const FileManager& file_manager = FileManager(),
+        const PersistencePolicy& policy = PersistencePolicy::WriteBehind(64, chrono::seconds(2)))
+        : store(file_manager), user_manager(store, policy), auth_service(user_manager),
+        question_manager(store, user_manager, policy) {}
+
+    // Runs a command script instead of the interactive menus
+    // Returns: True if every command succeeded
+    bool RunBatch(istream& script) {
+        BatchProcessor processor(user_manager, question_manager);
+        BatchProcessor::Report report = processor.Run(script, cout);
+        return report.applied == report.commands;
+    }
+
+    // Serves many clients at once over TCP until an admin sends "shutdown"
+    // Returns: True if the server ran and all changes were saved
+    bool RunServer(uint16_t port, const string& listen_address = "127.0.0.1") {
+#ifdef ASKME_HAS_SERVER
+        AskMeServer server(user_manager, question_manager);
+        return server.Run(port, cout, listen_address);
+#else
+        cerr << "Server mode is not supported on this platform (port " << port << ")\n";
+        return false;
+#endif
+    }
+
+    // Sets how many questions the admin feed shows per page (0 = no paging)
+    void SetFeedPageSize(size_t page_size) {
+        feed_page_size = page_size;
+    }
+
+    // Writes every pending change to disk
+    // Returns: True if all writes succeeded
+    bool Flush() {
+        bool users_saved = user_manager.Flush();
+        bool questions_saved = question_manager.Flush();
+        return users_saved && questions_saved;
+    }
+
     // Runs the main system loop
     void Run() {
         while (true) {
             while (!auth_service.IsLoggedIn()) {
+                user_manager.FlushIfDue();
+                question_manager.FlushIfDue();
                 ShowMainMenu();
                 int option;
-                cin >> option;
+                if (!(cin >> option)) {
+                    if (cin.eof()) {
+                        Flush();
+                        return; // End of input
+                    }
+                    cin.clear();
+                    cin.ignore(numeric_limits<streamsize>::max(), '\n');
+                    option = 0;
+                }
     
                 switch (option) {
                     case 1:
@@ -968,6 +3466,7 @@ public:
                         auth_service.SignUp();
                         break;
                     case 3:
+                        Flush();
                         cout << "Goodbye!\n";
                         return;
                     default:
@@ -981,9 +3480,19 @@ public:
                 // Admin menu loop
                 bool back_to_main = false;
                 while (auth_service.IsLoggedIn() && !back_to_main) {
+                    user_manager.FlushIfDue();
+                    question_manager.FlushIfDue();
                     ShowAdminMenu(current_user);
                     int choice;
-                    cin >> choice;
+                    if (!(cin >> choice)) {
+                        if (cin.eof()) {
+                            Flush();
+                            return; // End of input
+                        }
+                        cin.clear();
+                        cin.ignore(numeric_limits<streamsize>::max(), '\n');
+                        choice = 0;
+                    }
     
                     switch (choice) {
                         case 1:
@@ -996,9 +3505,16 @@ public:
                             user_manager.DeleteUser(id);
                             break;
                         }
-                        case 3:
-                            question_manager.GetFeed(current_user);
+                        case 3: {
+                            int last_shown = question_manager.GetFeed(current_user, 0, feed_page_size);
+                            while (last_shown != -1) {
+                                cout << "Show next page? (y/n): ";
+                                char response;
+                                if (!(cin >> response) || tolower(response) != 'y') break;
+                                last_shown = question_manager.GetFeed(current_user, last_shown, feed_page_size);
+                            }
                             break;
+                        }
                         case 4: {
                             int qid;
                             cout << "Enter question ID to delete: ";
@@ -1011,8 +3527,19 @@ public:
                             break;
                         case 6:
                             auth_service.Logout();
+                            Flush();
                             back_to_main = true;
                             break;
+                        case 7:
+                            question_manager.SearchQuestions(current_user);
+                            break;
+                        case 8:
+#ifdef ASKME_TRACE
+                            Trace::PrintSummary(cout);
+#else
+                            cout << "Tracing is not compiled in (build with -DASKME_TRACE).\n";
+#endif
+                            break;
                         default:
                             cout << "Invalid option. Try again.\n";
                     }
@@ -1022,9 +3549,19 @@ public:
                 // Regular user menu loop
                 bool back_to_main = false;
                 while (auth_service.IsLoggedIn() && !back_to_main) {
+                    user_manager.FlushIfDue();
+                    question_manager.FlushIfDue();
                     ShowUserMenu(current_user);
                     int choice;
-                    cin >> choice;
+                    if (!(cin >> choice)) {
+                        if (cin.eof()) {
+                            Flush();
+                            return; // End of input
+                        }
+                        cin.clear();
+                        cin.ignore(numeric_limits<streamsize>::max(), '\n');
+                        choice = 0;
+                    }
     
                     switch (choice) {
                         case 1:
@@ -1052,8 +3589,12 @@ public:
                             break;
                         case 7:
                             auth_service.Logout();
+                            Flush();
                             back_to_main = true;
                             break;
+                        case 8:
+                            question_manager.SearchQuestions(current_user);
+                            break;
                         default:
                             cout << "Invalid option. Try again.\n";
                     }
@@ -1063,8 +3604,354 @@ public:
     }
 };
 
-int main() {
-    AskMeSystem system;
-    system.Run();
+// Measures logins per second at several work factors, without the cache and with it
+// Runs on a scratch data directory, so the real data files are never touched
+// Returns: Process exit code
+int BenchmarkLogins(ostream& out) {
+    const filesystem::path scratch = filesystem::temp_directory_path() / "askme-login-benchmark";
+    filesystem::create_directories(scratch);
+    ofstream((scratch / "users.txt").string()).close();
+    ofstream((scratch / "questions.txt").string()).close();
+
+    out << left << setw(14) << "Work factor" << setw(20) << "Logins/sec (cold)" << "Logins/sec (cached)\n";
+    for (int rounds : {1000, 5000, 10000, 50000}) {
+        PasswordHasher::SetIterations(rounds);
+        DataStore store(FileManager((scratch / "users.txt").string(), (scratch / "questions.txt").string()));
+        UserManager user_manager(store, PersistencePolicy::Manual());
+        User user(user_manager.AllocateUserID(), "Benchmark User", "", "bench", "bench@example.com", false);
+        user.setPassword("correct horse battery staple");
+        user_manager.AddUser(user);
+
+        // Runs logins for at least a quarter of a second
+        auto measure = [&](bool cached) {
+            size_t logins = 0;
+            auto start = chrono::steady_clock::now();
+            double seconds = 0;
+            while (seconds < 0.25) {
+                if (!cached) {
+                    user_manager.ClearLoginCache();
+                }
+                if (!user_manager.Authenticate(user.getId(), "correct horse battery staple")) {
+                    throw runtime_error("Benchmark login failed");
+                }
+                ++logins;
+                seconds = chrono::duration<double>(chrono::steady_clock::now() - start).count();
+            }
+            return static_cast<long long>(logins / seconds);
+        };
+        long long cold = measure(false);
+        long long cached = measure(true);
+        out << setw(14) << rounds << setw(20) << cold << cached << "\n";
+    }
+    filesystem::remove_all(scratch);
+    PasswordHasher::SetIterations(PasswordHasher::DEFAULT_ITERATIONS);
+    return 0;
+}
+
+// Times single operations and reports their throughput and latency percentiles
+class LatencyRecorder {
+private:
+    string name;
+    vector<double> samples;     // Nanoseconds
+
+public:
+    explicit LatencyRecorder(string name) : name(move(name)) {}
+
+    template <class Work>
+    void Measure(Work work) {
+        auto start = chrono::steady_clock::now();
+        work();
+        samples.push_back(chrono::duration<double, nano>(chrono::steady_clock::now() - start).count());
+    }
+
+    // Same columns as the library and hospital benchmarks, so their output can be compared
+    static void PrintHeader(ostream& out) {
+        out << left << setw(28) << "Operation" << right << setw(10) << "Count" << setw(14) << "Ops/sec"
+            << setw(10) << "p50 us" << setw(10) << "p90 us" << setw(10) << "p99 us" << setw(10) << "Max us" << "\n";
+    }
+
+    void Print(ostream& out) const {
+        if (samples.empty()) {
+            return;
+        }
+        vector<double> sorted = samples;
+        sort(sorted.begin(), sorted.end());
+        double total_ns = accumulate(sorted.begin(), sorted.end(), 0.0);
+        auto at = [&](double fraction) {
+            return sorted[min(sorted.size() - 1, static_cast<size_t>(fraction * sorted.size()))] / 1000.0;
+        };
+        out << left << setw(28) << name << right << setw(10) << sorted.size()
+            << fixed << setprecision(0) << setw(14) << sorted.size() / (total_ns / 1e9)
+            << setprecision(2) << setw(10) << at(0.50) << setw(10) << at(0.90) << setw(10) << at(0.99)
+            << setw(10) << sorted.back() / 1000.0 << "\n";
+        out.unsetf(ios::floatfield);
+    }
+};
+
+// Times loading, printing, feed, search and asking on a synthetic dataset
+// The dataset is generated from a fixed seed into a scratch directory, so runs
+// are reproducible and the real data files are never touched
+// Returns: Process exit code
+int BenchmarkOperations(ostream& out, size_t user_count, size_t question_count) {
+    const filesystem::path scratch = filesystem::temp_directory_path() / "askme-benchmark";
+    filesystem::create_directories(scratch);
+    mt19937 random(42);
+    static const char* words[] = {"how", "why", "when", "does", "the", "compiler", "pointer", "template",
+        "vector", "thread", "memory", "cache", "socket", "string", "index", "search", "lock", "file"};
+    // Mostly common words, one in four drawn from a long tail of topic words
+    auto word = [&] {
+        return random() % 4 ? string(words[random() % size(words)]) : "topic" + to_string(random() % 5000);
+    };
+    auto sentence = [&](size_t length) {
+        string text;
+        for (size_t i = 0; i < length; ++i) {
+            text += (i ? " " : "") + word();
+        }
+        return text;
+    };
+
+    // Hashing is deliberately slow, so every user shares one stored hash
+    const string password_hash = PasswordHasher::Hash("benchmark", 1000);
+    unordered_map<int, User> users;
+    for (size_t i = 1; i <= user_count; ++i) {
+        int id = static_cast<int>(i);
+        users[id] = User(id, "User " + to_string(i), password_hash, "user" + to_string(i),
+            "user" + to_string(i) + "@example.com", true);
+    }
+    // The feed is admin-only; anyone else is turned away before a question is read
+    const User admin(0, "Benchmark Admin", password_hash, "admin", "admin@example.com", false, User::ADMIN);
+    unordered_map<int, Question> questions;
+    for (size_t i = 1; i <= question_count && user_count > 0; ++i) {
+        int id = static_cast<int>(i);
+        int parent_id = (i > 1 && random() % 10 < 3) ? static_cast<int>(1 + random() % (i - 1)) : -1;
+        if (parent_id != -1 && questions[parent_id].getParentId() != -1) {
+            parent_id = questions[parent_id].getParentId();
+        }
+        questions[id] = Question(id, parent_id, static_cast<int>(1 + random() % user_count),
+            static_cast<int>(1 + random() % user_count), random() % 4 == 0, sentence(8 + random() % 8),
+            random() % 2 ? sentence(6) : "");
+    }
+
+    const FileManager csv_files((scratch / "users.txt").string(), (scratch / "questions.txt").string(), FileManager::CSV);
+    const FileManager binary_files((scratch / "users.bin").string(), (scratch / "questions.bin").string(),
+        FileManager::BINARY);
+    for (const FileManager* files : {&csv_files, &binary_files}) {
+        if (!files->SaveUsers(users, static_cast<int>(user_count) + 1)
+            || !files->SaveQuestions(questions, static_cast<int>(question_count) + 1)) {
+            cerr << "Unable to write the benchmark dataset to " << scratch << "\n";
+            return 1;
+        }
+    }
+
+    LatencyRecorder load_csv("LoadQuestions (CSV)"), load_binary("LoadQuestions (binary)"),
+        open_managers("Load + index (CSV)"), to_user("PrintQuestionsToUser"), from_user("PrintQuestionsFromUser"),
+        feed("GetFeed (20 per page)"), search("Search"), ask("AddQuestion");
+    for (int run = 0; run < 5; ++run) {
+        load_csv.Measure([&] { csv_files.LoadQuestions(); });
+        load_binary.Measure([&] { binary_files.LoadQuestions(); });
+    }
+
+    DataStore store(csv_files);
+    unique_ptr<UserManager> user_manager;
+    unique_ptr<QuestionManager> question_manager;
+    open_managers.Measure([&] {
+        user_manager = make_unique<UserManager>(store, PersistencePolicy::Manual());
+        question_manager = make_unique<QuestionManager>(store, *user_manager, PersistencePolicy::Manual());
+    });
+
+    const size_t samples = min<size_t>(user_count, 2000);
+    ostringstream sink;
+    for (size_t i = 0; i < samples; ++i) {
+        int user_id = static_cast<int>(1 + random() % user_count);
+        sink.str("");
+        to_user.Measure([&] { question_manager->PrintQuestionsToUser(user_id, sink); });
+        sink.str("");
+        from_user.Measure([&] { question_manager->PrintQuestionsFromUser(user_id, sink); });
+        sink.str("");
+        int after_id = static_cast<int>(random() % max<size_t>(question_count, 1));
+        feed.Measure([&] { question_manager->GetFeed(admin, after_id, 20, sink); });
+        string query = word() + " topic" + to_string(random() % 5000);
+        search.Measure([&] { question_manager->Search(query); });
+    }
+    for (size_t i = 0; i < samples; ++i) {
+        Question question(question_manager->AllocateQuestionID(), -1, static_cast<int>(1 + random() % user_count),
+            static_cast<int>(1 + random() % user_count), false, sentence(10));
+        ask.Measure([&] { question_manager->AddQuestion(question); });
+    }
+
+    out << "Users: " << user_count << ", questions: " << question_count << ", sampled users: " << samples << "\n";
+    LatencyRecorder::PrintHeader(out);
+    for (const LatencyRecorder* recorder : {&load_csv, &load_binary, &open_managers, &to_user, &from_user,
+            &feed, &search, &ask}) {
+        recorder->Print(out);
+    }
+
+    question_manager.reset();
+    user_manager.reset();
+    filesystem::remove_all(scratch);
+    return 0;
+}
+
+// Imports a questions file whose replies come before their parents, as SaveQuestions() may write it
+void TestImportRepliesBeforeParents(ostream& out) {
+    out << "Test: Import replies before parents\n";
+    const filesystem::path scratch = filesystem::temp_directory_path() / "askme-self-test";
+    filesystem::remove_all(scratch);
+    filesystem::create_directories(scratch);
+    const FileManager files((scratch / "users.txt").string(), (scratch / "questions.txt").string(), FileManager::CSV);
+    const string password_hash = PasswordHasher::Hash("test", 1000);
+    unordered_map<int, User> users;
+    users[1] = User(1, "Asker", password_hash, "asker", "asker@example.com", true);
+    users[2] = User(2, "Answerer", password_hash, "answerer", "answerer@example.com", true);
+    assert(files.SaveUsers(users, 3) && files.SaveQuestions({}, 1));
+
+    const string import_path = (scratch / "import.txt").string();
+    {
+        ofstream import(import_path);
+        import << "12,10,1,2,0,Second follow-up?,\n"
+               << "11,10,2,1,0,Follow-up?,\n"
+               << "10,-1,1,2,0,First question?,\n";
+    }
+    {
+        DataStore store(files);
+        UserManager user_manager(store, PersistencePolicy::Manual());
+        QuestionManager question_manager(store, user_manager, PersistencePolicy::Manual());
+        BatchProcessor processor(user_manager, question_manager);
+        istringstream script("import-questions " + import_path + "\n");
+        ostringstream log;
+        BatchProcessor::Report report = processor.Run(script, log);
+        assert(report.commands == 3 && report.applied == 3);
+        assert(question_manager.GetQuestionByID(11).getParentId() == 10);
+        assert(question_manager.GetQuestionByID(12).getParentId() == 10);
+    }
+    filesystem::remove_all(scratch);
+    out << "Passed: Import replies before parents\n";
+}
+
+// Runs every self-test; a failed check aborts
+int RunSelfTests(ostream& out) {
+    TestImportRepliesBeforeParents(out);
+    out << "All self-tests passed.\n";
+    return 0;
+}
+
+// Reads a non-negative count from the command line
+// Returns: fallback if the argument is not a number (or does not fit)
+size_t ParseCount(string_view argument, size_t fallback) {
+    size_t value = 0;
+    auto [end, error] = from_chars(argument.data(), argument.data() + argument.size(), value);
+    return error == errc() && end == argument.data() + argument.size() ? value : fallback;
+}
+
+// Usage: AskMe [--binary | --convert-to-binary | --convert-to-csv] [--non-interactive] [--batch <file>]
+//              [--server <port> [--listen <address>]] [--work-factor <n>] [--load-threads <n>] [--benchmark-login]
+//              [--benchmark [users] [questions]] [--self-test]
+//   --binary             Run on users.bin/questions.bin instead of the CSV files
+//   --batch <file>       Apply a command script (see BatchProcessor; "-" reads stdin) and exit
+//   --server <port>      Serve many clients at once over TCP (see ClientSession for the protocol)
+//   --listen <address>   IPv4 address the server binds (default 127.0.0.1; the protocol is plain text)
+//   --work-factor <n>    PBKDF2 iterations for new password hashes (weaker hashes are upgraded at login)
+//   --load-threads <n>   Threads used to parse the data files and build indexes (default: one per core)
+//   --benchmark-login    Report logins per second at several work factors and exit
+//   --benchmark          Time the hot operations on a synthetic dataset (default 5000 users, 50000 questions)
+//   --self-test          Run the built-in checks on scratch files and exit
+//   --non-interactive    Input is piped: untie cin/cout and print the feed unpaged
+//   --convert-to-binary  Write the CSV data to users.bin/questions.bin and exit
+//   --convert-to-csv     Write the binary data to users.txt/questions.txt and exit
+// Built with -DASKME_TRACE, the trace summary is also printed to stderr on exit.
+int main(int argc, char* argv[]) {
+#ifdef ASKME_TRACE
+    struct TraceOnExit {
+        ~TraceOnExit() { Trace::PrintSummary(cerr); }
+    } trace_on_exit;
+#endif
+    const FileManager csv_files("users.txt", "questions.txt", FileManager::CSV);
+    const FileManager binary_files("users.bin", "questions.bin", FileManager::BINARY);
+    string mode; // At most one of the mode flags; flags may come in any order
+    size_t benchmark_users = 5000, benchmark_questions = 50000;
+    bool interactive = true;
+    string batch_file;
+    int server_port = 0;
+    string listen_address = "127.0.0.1";
+    auto count_follows = [&](int i) { return i + 1 < argc && isdigit(static_cast<unsigned char>(argv[i + 1][0])); };
+    for (int i = 1; i < argc; ++i) {
+        const string argument = argv[i];
+        if (argument == "--binary" || argument == "--convert-to-binary" || argument == "--convert-to-csv" ||
+            argument == "--benchmark-login" || argument == "--benchmark" || argument == "--self-test") {
+            if (!mode.empty() && mode != argument) {
+                cerr << "Conflicting options: " << mode << " and " << argument << "\n";
+                return 1;
+            }
+            mode = argument;
+            if (mode == "--benchmark" && count_follows(i)) {
+                benchmark_users = ParseCount(argv[++i], benchmark_users);
+                if (count_follows(i)) {
+                    benchmark_questions = ParseCount(argv[++i], benchmark_questions);
+                }
+            }
+        } else if (argument == "--non-interactive") {
+            interactive = false;
+        } else if (argument == "--batch" && i + 1 < argc) {
+            batch_file = argv[++i];
+            interactive = false;
+        } else if (argument == "--server" && i + 1 < argc) {
+            server_port = atoi(argv[++i]);
+        } else if (argument == "--listen" && i + 1 < argc) {
+            listen_address = argv[++i];
+        } else if (argument == "--work-factor" && i + 1 < argc) {
+            PasswordHasher::SetIterations(atoi(argv[++i]));
+        } else if (argument == "--load-threads" && i + 1 < argc) {
+            ParallelWork::SetThreads(static_cast<unsigned>(max(0, atoi(argv[++i]))));
+        } else {
+            cerr << "Unknown option: " << argument << " (see the usage comment above main)\n";
+            return 1;
+        }
+    }
+    if (!interactive) {
+        // Nobody is watching the prompts, so don't flush cout before every read
+        ios::sync_with_stdio(false);
+        cin.tie(nullptr);
+    }
+
+    try {
+        if (mode == "--convert-to-binary") {
+            return FileManager::Convert(csv_files, binary_files) ? 0 : 1;
+        }
+        if (mode == "--convert-to-csv") {
+            return FileManager::Convert(binary_files, csv_files) ? 0 : 1;
+        }
+        if (mode == "--benchmark-login") {
+            return BenchmarkLogins(cout);
+        }
+        if (mode == "--benchmark") {
+            return BenchmarkOperations(cout, benchmark_users, benchmark_questions);
+        }
+        if (mode == "--self-test") {
+            return RunSelfTests(cout);
+        }
+
+        AskMeSystem system(mode == "--binary" ? binary_files : csv_files);
+        if (!interactive) {
+            system.SetFeedPageSize(0);
+        }
+        if (!batch_file.empty()) {
+            if (batch_file == "-") {
+                return system.RunBatch(cin) ? 0 : 1;
+            }
+            ifstream script(batch_file);
+            if (!script.is_open()) {
+                cerr << "Unable to open batch file: " << batch_file << "\n";
+                return 1;
+            }
+            return system.RunBatch(script) ? 0 : 1;
+        }
+        if (server_port > 0) {
+            return system.RunServer(static_cast<uint16_t>(server_port), listen_address) ? 0 : 1;
+        }
+        system.Run();
+    } catch (const exception& e) {
+        cerr << "Fatal error: " << e.what() << "\n";
+        return 1;
+    }
     return 0;
 }
\ No newline at end of file
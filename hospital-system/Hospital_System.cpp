@@ -1,17 +1,41 @@
 #include <bits/stdc++.h>
+#ifdef _WIN32
+#include <io.h>
+#else
+#include <unistd.h>
+#endif
 using namespace std;
 
+// Triage levels, lowest to highest; higher levels are always served first
+enum Priority {
+    REGULAR,
+    URGENT,
+    CRITICAL,
+    PRIORITY_LEVELS
+};
+
 class Patient {
 private:
+    int id = 0;     // Assigned by the hospital when the patient is queued
     string name = "";
     int age = 0;
     string phone_number = "";
     string address = "";
-    bool statu = 0;
+    Priority statu = REGULAR;
 
 public:
-    Patient(string name, int age, string phone_number, string address, bool statu)
-        : name(name), age(age), phone_number(phone_number), address(address), statu(statu) {}
+    Patient() = default;
+
+    Patient(string name, int age, string phone_number, string address, Priority statu)
+        : name(move(name)), age(age), phone_number(move(phone_number)), address(move(address)), statu(statu) {}
+
+    int get_id() const {
+        return id;
+    }
+
+    void set_id(int id) {
+        this->id = id;
+    }
 
     string get_name() const {
         return name;
@@ -29,20 +53,1226 @@ public:
         return address;
     }
 
+    Priority get_priority() const {
+        return statu;
+    }
+
+    void set_priority(Priority statu) {
+        this->statu = statu;
+    }
+
     const char* get_statu() const {
-        return statu == 0 ? "Regular" : "Urgent";
+        static const char* names[PRIORITY_LEVELS] = {"Regular", "Urgent", "Critical"};
+        return names[statu];
+    }
+};
+
+// Growable FIFO ring buffer over one contiguous array (capacity is a power of two)
+template <class T>
+class RingBuffer {
+private:
+    vector<T> slots;
+    size_t head = 0;    // Index of the oldest element
+    size_t count = 0;
+
+    void grow() {
+        vector<T> bigger(max<size_t>(8, slots.size() * 2));
+        for (size_t i = 0; i < count; ++i) {
+            bigger[i] = move(slots[(head + i) & (slots.size() - 1)]);
+        }
+        slots.swap(bigger);
+        head = 0;
+    }
+
+public:
+    void push_back(T value) {
+        if (count == slots.size()) {
+            grow();
+        }
+        slots[(head + count) & (slots.size() - 1)] = move(value);
+        ++count;
+    }
+
+    const T& front() const {
+        return slots[head];
+    }
+
+    void pop_front() {
+        head = (head + 1) & (slots.size() - 1);
+        --count;
+    }
+
+    // i-th element from the front
+    const T& operator[](size_t i) const {
+        return slots[(head + i) & (slots.size() - 1)];
+    }
+
+    bool empty() const {
+        return count == 0;
+    }
+
+    size_t size() const {
+        return count;
+    }
+};
+
+// Owns every waiting patient; queues hold small handles into it
+// Freed slots are reused, so the pool stays as large as the peak waiting count.
+// A cancelled slot stays allocated (as a tombstone) until its queue pops it.
+class PatientPool {
+public:
+    using Clock = chrono::steady_clock;
+
+private:
+    vector<Patient> patients;
+    vector<char> cancelled;
+    vector<Clock::time_point> arrived;     // When the patient joined the line
+    vector<uint32_t> free_slots;
+
+public:
+    uint32_t add(const Patient& patient, Clock::time_point arrival = Clock::now()) {
+        if (!free_slots.empty()) {
+            uint32_t handle = free_slots.back();
+            free_slots.pop_back();
+            patients[handle] = patient;
+            cancelled[handle] = false;
+            arrived[handle] = arrival;
+            return handle;
+        }
+        patients.push_back(patient);
+        cancelled.push_back(false);
+        arrived.push_back(arrival);
+        return static_cast<uint32_t>(patients.size() - 1);
+    }
+
+    Clock::time_point arrival(uint32_t handle) const {
+        return arrived[handle];
+    }
+
+    void cancel(uint32_t handle) {
+        cancelled[handle] = true;
+    }
+
+    bool is_cancelled(uint32_t handle) const {
+        return cancelled[handle];
+    }
+
+    const Patient& get(uint32_t handle) const {
+        return patients[handle];
+    }
+
+    void release(uint32_t handle) {
+        free_slots.push_back(handle);
+    }
+};
+
+// Waiting line of one specialization: one FIFO ring of patient handles per
+// priority level, so enqueue and dequeue are O(1) and patients of the same
+// level keep their order
+class TriageQueue {
+private:
+    array<RingBuffer<uint32_t>, PRIORITY_LEVELS> levels;
+    size_t count = 0;
+
+    // Highest level with someone waiting (the queue must not be empty)
+    int top_level() const {
+        int level = PRIORITY_LEVELS - 1;
+        while (level > REGULAR && levels[level].empty()) {
+            --level;
+        }
+        return level;
+    }
+
+public:
+    void push(uint32_t handle, Priority priority) {
+        levels[priority].push_back(handle);
+        ++count;
+    }
+
+    // Handle of the patient to serve next (the queue must not be empty)
+    uint32_t front() const {
+        return levels[top_level()].front();
+    }
+
+    void pop() {
+        levels[top_level()].pop_front();
+        --count;
+    }
+
+    bool empty() const {
+        return count == 0;
+    }
+
+    size_t size() const {
+        return count;
+    }
+
+    // Visits the handles in the order they will be served
+    template <class Visit>
+    void for_each(Visit visit) const {
+        for (int level = PRIORITY_LEVELS - 1; level >= REGULAR; --level) {
+            for (size_t i = 0; i < levels[level].size(); ++i) {
+                visit(levels[level][i]);
+            }
+        }
+    }
+};
+
+// Lock-free histogram of durations in microseconds. Buckets are log-linear
+// (four per power of two), so percentiles are within 12.5% of the true value
+// and recording is a single relaxed atomic increment.
+class WaitHistogram {
+private:
+    static constexpr int SUB_BUCKETS = 4;
+    static constexpr int BUCKETS = 64 * SUB_BUCKETS;
+
+    array<atomic<uint64_t>, BUCKETS> buckets{};
+    atomic<uint64_t> count{0};
+    atomic<uint64_t> total{0};
+    atomic<uint64_t> largest{0};
+
+    static int bucket_of(uint64_t us) {
+        if (us < SUB_BUCKETS) {
+            return static_cast<int>(us);
+        }
+        int exponent = 63 - __builtin_clzll(us);
+        int sub = static_cast<int>((us >> (exponent - 2)) & (SUB_BUCKETS - 1));
+        return (exponent - 1) * SUB_BUCKETS + sub;
+    }
+
+    static uint64_t lower_bound_of(int bucket) {
+        if (bucket < SUB_BUCKETS) {
+            return bucket;
+        }
+        int exponent = bucket / SUB_BUCKETS + 1;
+        return uint64_t(SUB_BUCKETS + bucket % SUB_BUCKETS) << (exponent - 2);
+    }
+
+public:
+    void record(uint64_t us) {
+        buckets[bucket_of(us)].fetch_add(1, memory_order_relaxed);
+        count.fetch_add(1, memory_order_relaxed);
+        total.fetch_add(us, memory_order_relaxed);
+        uint64_t seen = largest.load(memory_order_relaxed);
+        while (us > seen && !largest.compare_exchange_weak(seen, us, memory_order_relaxed)) {
+        }
+    }
+
+    uint64_t samples() const {
+        return count.load(memory_order_relaxed);
+    }
+
+    uint64_t mean() const {
+        uint64_t n = samples();
+        return n == 0 ? 0 : total.load(memory_order_relaxed) / n;
+    }
+
+    uint64_t maximum() const {
+        return largest.load(memory_order_relaxed);
+    }
+
+    // Approximate value below which the given fraction (0..1) of samples fall
+    uint64_t percentile(double fraction) const {
+        uint64_t n = samples();
+        if (n == 0) {
+            return 0;
+        }
+        uint64_t rank = static_cast<uint64_t>(ceil(fraction * n)), seen = 0;
+        for (int b = 0; b < BUCKETS; ++b) {
+            seen += buckets[b].load(memory_order_relaxed);
+            if (seen >= max<uint64_t>(rank, 1)) {
+                // Midpoint of the bucket, never above the largest sample
+                uint64_t low = lower_bound_of(b), high = b + 1 < BUCKETS ? lower_bound_of(b + 1) : low;
+                return min(low + (high - low) / 2, maximum());
+            }
+        }
+        return maximum();
+    }
+};
+
+// Counters of one specialization; every field is updated with relaxed atomics,
+// so exporting never takes the queue lock and recording never waits for an export
+struct QueueStats {
+    array<atomic<uint64_t>, PRIORITY_LEVELS> arrivals{};    // By priority on arrival
+    array<atomic<uint64_t>, PRIORITY_LEVELS> served{};      // By priority when served
+    array<WaitHistogram, PRIORITY_LEVELS> wait_us;          // Enqueue -> served, by priority when served
+    atomic<uint64_t> cancelled{0};
+    atomic<uint64_t> escalated{0};
+    atomic<uint64_t> turned_away{0};
+    atomic<uint64_t> depth{0};
+    atomic<uint64_t> max_depth{0};
+
+    void set_depth(uint64_t value) {
+        depth.store(value, memory_order_relaxed);
+        if (value > max_depth.load(memory_order_relaxed)) {
+            max_depth.store(value, memory_order_relaxed);   // Only written under the queue lock
+        }
+    }
+};
+
+// FNV-1a hash guarding log records and the checkpoint body
+static uint32_t checksum(string_view data) {
+    uint32_t hash = 2166136261u;
+    for (char c : data) {
+        hash = (hash ^ static_cast<uint8_t>(c)) * 16777619u;
+    }
+    return hash;
+}
+
+// Pushes a stream's buffered bytes through the OS cache onto the disk
+static bool sync_to_disk(FILE* file) {
+    if (fflush(file) != 0) {
+        return false;
+    }
+#ifdef _WIN32
+    return _commit(_fileno(file)) == 0;
+#else
+    return fsync(fileno(file)) == 0;
+#endif
+}
+
+// Little-endian encoder for log records and checkpoints
+class RecordWriter {
+private:
+    string bytes;
+
+public:
+    void u8(uint8_t value) {
+        bytes += static_cast<char>(value);
+    }
+
+    void u32(uint32_t value) {
+        for (int i = 0; i < 4; ++i) {
+            bytes += static_cast<char>(value >> (8 * i));
+        }
+    }
+
+    void i32(int value) {
+        u32(static_cast<uint32_t>(value));
+    }
+
+    void str(const string& value) {
+        u32(static_cast<uint32_t>(value.size()));
+        bytes += value;
+    }
+
+    const string& data() const {
+        return bytes;
+    }
+};
+
+// Bounds-checked decoder; reading past the end clears ok() instead of throwing
+class RecordReader {
+private:
+    string_view bytes;
+    bool good = true;
+
+public:
+    explicit RecordReader(string_view bytes) : bytes(bytes) {}
+
+    uint8_t u8() {
+        string_view raw = take(1);
+        return raw.empty() ? 0 : static_cast<uint8_t>(raw[0]);
+    }
+
+    uint32_t u32() {
+        string_view raw = take(4);
+        uint32_t value = 0;
+        for (size_t i = 0; i < raw.size(); ++i) {
+            value |= uint32_t(static_cast<uint8_t>(raw[i])) << (8 * i);
+        }
+        return value;
+    }
+
+    int i32() {
+        return static_cast<int>(u32());
+    }
+
+    string str() {
+        uint32_t size = u32();
+        return string(take(size));
+    }
+
+    string_view take(size_t size) {
+        if (bytes.size() < size) {
+            good = false;
+            bytes = {};
+            return {};
+        }
+        string_view value = bytes.substr(0, size);
+        bytes.remove_prefix(size);
+        return value;
+    }
+
+    bool ok() const {
+        return good;
+    }
+
+    bool done() const {
+        return bytes.empty();
+    }
+
+    size_t remaining() const {
+        return bytes.size();
+    }
+};
+
+// Append-only file of records with group commit: append() only copies the
+// record into a buffer, and a writer thread writes and fsyncs everything
+// buffered at most every FLUSH_INTERVAL (or sooner when asked to sync), so
+// one disk flush serves many callers.
+// A record is durable only once sync() returns true; acknowledge changes after that.
+// After a failed write the file is cut back to the last good record and nothing
+// more is appended, so a torn record is never followed by others.
+// Record: payload length, FNV-1a checksum of the payload, payload
+class EventLog {
+private:
+    static constexpr chrono::milliseconds FLUSH_INTERVAL{2};
+    static constexpr size_t FLUSH_BYTES = 64 * 1024;
+
+    string path;
+    FILE* file = nullptr;
+    thread writer;
+    mutable mutex lock;
+    condition_variable wake;        // Writer: there is work or a sync request
+    condition_variable written;     // Syncers: a batch hit the file
+    string pending;
+    uint64_t appended = 0;          // Records handed to append()
+    uint64_t flushed = 0;           // Records written and synced to disk
+    uint64_t sync_target = 0;       // Highest record count a sync() waits for
+    bool stopping = false;
+    bool failed = false;            // A write failed; sticky until reset()
+    uintmax_t good_size = 0;        // File size up to the last record written and synced
+    size_t records = 0;             // Records in the file (incl. pending) since the last reset
+
+    // Writes and syncs one batch; on failure cuts the file back to the last
+    // good record and closes it
+    bool write_batch(const string& batch) {
+        if (file && fwrite(batch.data(), 1, batch.size(), file) == batch.size() && sync_to_disk(file)) {
+            good_size += batch.size();
+            return true;
+        }
+        cout << "Unable to write log file: " << path << "\n";
+        if (file) {
+            fclose(file);
+            file = nullptr;
+        }
+        error_code error;
+        filesystem::resize_file(path, good_size, error);
+        return false;
+    }
+
+    void write_loop() {
+        unique_lock<mutex> guard(lock);
+        while (true) {
+            wake.wait_for(guard, FLUSH_INTERVAL, [&] {
+                return stopping || flushed < sync_target || pending.size() >= FLUSH_BYTES;
+            });
+            if (!pending.empty()) {
+                string batch;
+                batch.swap(pending);
+                uint64_t upto = appended;
+                bool ok = !failed;  // Batches after a failed one are dropped
+                guard.unlock();
+                ok = ok && write_batch(batch);
+                guard.lock();
+                failed = !ok;
+                flushed = upto;
+                written.notify_all();
+            }
+            if (stopping && pending.empty()) {
+                return;
+            }
+        }
+    }
+
+public:
+    ~EventLog() {
+        close();
+    }
+
+    // Calls visit for every intact record in the file, cuts off a torn
+    // record at the end, then opens the file for appending
+    // Returns: False if a record before the last one is damaged (nothing is
+    // cut off then, so the file can be inspected) or the file cannot be opened
+    template <class Visit>
+    bool open(const string& log_path, Visit visit) {
+        path = log_path;
+        records = 0;
+        ifstream in(path, ios::binary);
+        if (in) {
+            string contents((istreambuf_iterator<char>(in)), istreambuf_iterator<char>());
+            in.close();
+            RecordReader reader(contents);
+            while (!reader.done()) {
+                size_t record_start = contents.size() - reader.remaining();
+                uint32_t size = reader.u32();
+                uint32_t expected = reader.u32();
+                string_view payload = reader.take(size);
+                if (!reader.ok() || (checksum(payload) != expected && reader.done())) {
+                    cout << "Ignoring an incomplete record at the end of " << path << "\n";
+                    error_code error;
+                    filesystem::resize_file(path, record_start, error);
+                    break;
+                }
+                if (checksum(payload) != expected) {
+                    cout << "Corrupted record at byte " << record_start << " of " << path << "\n";
+                    return false;
+                }
+                RecordReader record(payload);
+                visit(record);
+                ++records;
+            }
+        }
+
+        file = fopen(path.c_str(), "ab");
+        if (!file) {
+            cout << "Unable to open log file: " << path << "\n";
+            return false;
+        }
+        error_code error;
+        good_size = filesystem::file_size(path, error);
+        if (error) {
+            good_size = 0;
+        }
+        failed = false;
+        stopping = false;
+        writer = thread(&EventLog::write_loop, this);
+        return true;
+    }
+
+    void append(const RecordWriter& record) {
+        RecordWriter frame;
+        frame.u32(static_cast<uint32_t>(record.data().size()));
+        frame.u32(checksum(record.data()));
+        lock_guard<mutex> guard(lock);
+        pending += frame.data();
+        pending += record.data();
+        ++appended;
+        ++records;
+    }
+
+    // Blocks until every record appended so far is on disk
+    // Returns: False if a write failed since the log was opened or last reset,
+    // so records appended since then will not survive a restart
+    bool sync() {
+        unique_lock<mutex> guard(lock);
+        if (writer.joinable()) {
+            uint64_t target = appended;
+            sync_target = max(sync_target, target);
+            wake.notify_one();
+            written.wait(guard, [&] { return flushed >= target; });
+        }
+        return !failed;
+    }
+
+    // Empties the file once a checkpoint holds its contents
+    // Callers must make sure nothing is appended concurrently
+    void reset() {
+        sync();
+        lock_guard<mutex> guard(lock);
+        if (file) {
+            fclose(file);
+        }
+        file = fopen(path.c_str(), "wb");
+        if (!file) {
+            cout << "Unable to reopen log file: " << path << "\n";
+        }
+        failed = !file; // The checkpoint holds whatever a failed write lost
+        good_size = 0;
+        records = 0;
+    }
+
+    void close() {
+        {
+            lock_guard<mutex> guard(lock);
+            stopping = true;
+        }
+        wake.notify_one();
+        if (writer.joinable()) {
+            writer.join();
+        }
+        if (file) {
+            fclose(file);
+            file = nullptr;
+        }
+    }
+
+    size_t size() const {
+        lock_guard<mutex> guard(lock);
+        return records;
     }
 };
 
+// Specializations are independent: each one has its own lock, so desks and
+// doctors working on different specializations never wait for each other.
+// The table itself is fixed once desks and doctors are running; register
+// specializations before starting them.
 class HospitalSystem {
 private:
-    map<int, deque<Patient>> specialization;
+    struct Specialization {
+        size_t capacity = 0;    // 0 = no limit
+        size_t waiting = 0;     // Queued patients, not counting tombstones
+        TriageQueue queue;
+        PatientPool patients;
+        unordered_map<int, uint32_t> handles;   // Patient ID -> live handle in queue
+        QueueStats stats;
+        mutable mutex lock;
+        condition_variable arrived;     // Signalled when a patient is queued or the system closes
+    };
+
+    vector<unique_ptr<Specialization>> specialization;  // Indexed by specialization ID, null = not registered
+    size_t default_capacity;
+    atomic<bool> closed{false};
+
+    // Patient ID -> specialization they wait in. Never held together with a
+    // specialization lock; the specialization's own handle map is authoritative.
+    unordered_map<int, int> registry;
+    mutable mutex registry_lock;
+    atomic<int> next_patient_id{1};
+
+    static constexpr uint32_t CHECKPOINT_VERSION = 1;
+    static constexpr int MAX_SPECIALIZATION_ID = 1 << 16;  // Bounds the table against bad input
+
+    enum EventType : uint8_t {
+        PATIENT_ADDED = 1,
+        PATIENT_SERVED,
+        PATIENT_CANCELLED,
+        PATIENT_ESCALATED,
+        CAPACITY_CHANGED
+    };
+
+    unique_ptr<EventLog> events;    // Null while not persisting (or while replaying)
+    string checkpoint_path;
+    size_t checkpoint_records = 0;
+
+    static void write_patient(RecordWriter& out, const Patient& patient) {
+        out.i32(patient.get_id());
+        out.u8(static_cast<uint8_t>(patient.get_priority()));
+        out.i32(patient.get_age());
+        out.str(patient.get_name());
+        out.str(patient.get_phone_number());
+        out.str(patient.get_address());
+    }
+
+    static Patient read_patient(RecordReader& in) {
+        int id = in.i32();
+        int statu = min<int>(in.u8(), PRIORITY_LEVELS - 1);
+        int age = in.i32();
+        string name = in.str();
+        string phone = in.str();
+        Patient patient(name, age, phone, in.str(), static_cast<Priority>(statu));
+        patient.set_id(id);
+        return patient;
+    }
+
+    // Appends one event (the specialization lock must be held, so events of a
+    // specialization are logged in the order they were applied)
+    void log_event(EventType type, int first, int second = 0) {
+        if (events) {
+            RecordWriter record;
+            record.u8(type);
+            record.i32(first);
+            record.i32(second);
+            events->append(record);
+        }
+    }
+
+    void log_added(int s, const Patient& patient) {
+        if (events) {
+            RecordWriter record;
+            record.u8(PATIENT_ADDED);
+            record.i32(s);
+            write_patient(record, patient);
+            events->append(record);
+        }
+    }
+
+    // Queues a patient read back from disk, keeping their ID and ignoring capacity;
+    // their wait is measured from the restart.
+    // A patient already present is skipped: after a crash between writing a
+    // checkpoint and emptying the log, the log repeats what the checkpoint holds.
+    // Only used while loading, before anyone else touches the queues
+    void restore_patient(int s, const Patient& patient) {
+        if (registry.count(patient.get_id())) {
+            return;
+        }
+        if (!is_valid_specialization(s)) {
+            register_specialization(s, default_capacity);
+        }
+        Specialization& spec = *specialization[s];
+        uint32_t handle = spec.patients.add(patient);
+        spec.queue.push(handle, patient.get_priority());
+        spec.handles[patient.get_id()] = handle;
+        ++spec.waiting;
+        spec.stats.set_depth(spec.waiting);
+        registry[patient.get_id()] = s;
+        next_patient_id.store(max(next_patient_id.load(), patient.get_id() + 1));
+    }
+
+    void apply_event(RecordReader& record) {
+        switch (record.u8()) {
+        case PATIENT_ADDED: {
+            int s = record.i32();
+            Patient patient = read_patient(record);
+            if (record.ok() && s >= 0) {
+                restore_patient(s, patient);
+            }
+            break;
+        }
+        case PATIENT_SERVED:
+        case PATIENT_CANCELLED:
+            // Either way the patient left the line; a served one was at the front
+            cancel_patient(record.i32());
+            break;
+        case PATIENT_ESCALATED: {
+            int id = record.i32();
+            escalate_patient(id, static_cast<Priority>(min(record.i32(), PRIORITY_LEVELS - 1)));
+            break;
+        }
+        case CAPACITY_CHANGED: {
+            int s = record.i32();
+            size_t limit = static_cast<uint32_t>(record.i32());
+            if (!set_capacity(s, limit) && s >= 0) {
+                register_specialization(s, limit);
+            }
+            break;
+        }
+        default:
+            cout << "Skipping an unknown event in the hospital log\n";
+        }
+    }
+
+    bool load_checkpoint() {
+        ifstream file(checkpoint_path, ios::binary);
+        if (!file) {
+            return true; // No checkpoint yet
+        }
+        string contents((istreambuf_iterator<char>(file)), istreambuf_iterator<char>());
+        RecordReader in(contents);
+        if (in.take(4) != "HOSP" || in.u32() != CHECKPOINT_VERSION) {
+            cout << "Unrecognized checkpoint file: " << checkpoint_path << "\n";
+            return false;
+        }
+        int next_id = in.i32();
+        uint32_t count = in.u32();
+        uint32_t expected = in.u32();
+        string_view body_bytes = string_view(contents).substr(contents.size() - in.remaining());
+        if (!in.ok() || checksum(body_bytes) != expected) {
+            cout << "Corrupted checkpoint file: " << checkpoint_path << "\n";
+            return false;
+        }
+
+        // Decoded in full before anything is queued, so a bad body leaves the queues untouched
+        struct Saved {
+            int s;
+            size_t limit;
+            vector<Patient> waiting;
+        };
+        vector<Saved> saved;
+        RecordReader body(body_bytes);
+        for (uint32_t i = 0; i < count && body.ok(); ++i) {
+            Saved spec{body.i32(), body.u32(), {}};
+            uint32_t waiting = body.u32();
+            for (uint32_t k = 0; k < waiting && body.ok(); ++k) {
+                spec.waiting.push_back(read_patient(body));
+            }
+            saved.push_back(move(spec));
+        }
+        bool valid = body.ok() && body.done();
+        for (const Saved& spec : saved) {
+            valid = valid && spec.s >= 0 && spec.s <= MAX_SPECIALIZATION_ID;
+        }
+        if (!valid) {
+            cout << "Corrupted checkpoint file: " << checkpoint_path << "\n";
+            return false;
+        }
+
+        for (const Saved& spec : saved) {
+            register_specialization(spec.s, spec.limit);
+            for (const Patient& patient : spec.waiting) {
+                restore_patient(spec.s, patient);
+            }
+        }
+        next_patient_id.store(max(next_patient_id.load(), next_id));
+        return true;
+    }
 
     void print_separator() const {
         cout << "\n=======================================================\n";
     }
 
+    // Pops cancelled patients off the front of a queue (its lock must be held)
+    static void drop_cancelled(Specialization& spec) {
+        while (!spec.queue.empty() && spec.patients.is_cancelled(spec.queue.front())) {
+            spec.patients.release(spec.queue.front());
+            spec.queue.pop();
+        }
+    }
+
+    // Removes the next patient of a specialization (its lock must be held and someone waiting)
+    Patient take_front(Specialization& spec) {
+        drop_cancelled(spec);
+        uint32_t handle = spec.queue.front();
+        Patient patient = spec.patients.get(handle);
+        auto waited = chrono::duration_cast<chrono::microseconds>(PatientPool::Clock::now() - spec.patients.arrival(handle));
+        spec.queue.pop();
+        spec.patients.release(handle);
+        spec.handles.erase(patient.get_id());
+        --spec.waiting;
+        log_event(PATIENT_SERVED, patient.get_id());
+
+        Priority priority = patient.get_priority();
+        spec.stats.served[priority].fetch_add(1, memory_order_relaxed);
+        spec.stats.wait_us[priority].record(waited.count());
+        spec.stats.set_depth(spec.waiting);
+        return patient;
+    }
+
+    // Returns: The specialization a patient waits in, or -1 if not waiting
+    int locate(int id) const {
+        lock_guard<mutex> guard(registry_lock);
+        auto it = registry.find(id);
+        return it == registry.end() ? -1 : it->second;
+    }
+
+    void forget(int id) {
+        lock_guard<mutex> guard(registry_lock);
+        registry.erase(id);
+    }
+
 public:
+    // Registers specializations 1..specialization_count, each holding up to
+    // default_capacity waiting patients (0 = no limit)
+    HospitalSystem(int specialization_count = 20, size_t default_capacity = 5) : default_capacity(default_capacity) {
+        for (int s = 1; s <= specialization_count; ++s) {
+            register_specialization(s, default_capacity);
+        }
+    }
+
+    ~HospitalSystem() {
+        close_store();
+    }
+
+    // Adds (or re-configures) a specialization; IDs are small, so the table stays dense
+    // Not safe while desks or doctors are running
+    void register_specialization(int s, size_t limit) {
+        if (s < 0 || s > MAX_SPECIALIZATION_ID) {
+            return;
+        }
+        if (s >= (int)specialization.size()) {
+            specialization.resize(s + 1);
+        }
+        if (!specialization[s]) {
+            specialization[s] = make_unique<Specialization>();
+        }
+        specialization[s]->capacity = limit;
+    }
+
+    bool is_valid_specialization(int s) const {
+        return s >= 0 && s < (int)specialization.size() && specialization[s];
+    }
+
+    // Comma-separated IDs of the registered specializations, for error messages
+    string list_specializations() const {
+        string ids;
+        for (int s = 0; s < (int)specialization.size(); ++s) {
+            if (specialization[s]) {
+                ids += (ids.empty() ? "" : ", ") + to_string(s);
+            }
+        }
+        return ids;
+    }
+
+    // Sets how many patients may wait in one specialization (0 = no limit)
+    // Returns: False for an unknown specialization
+    bool set_capacity(int s, size_t limit) {
+        if (!is_valid_specialization(s)) {
+            return false;
+        }
+        lock_guard<mutex> guard(specialization[s]->lock);
+        specialization[s]->capacity = limit;
+        log_event(CAPACITY_CHANGED, s, static_cast<int>(limit));
+        return true;
+    }
+
+    size_t get_capacity(int s) const {
+        if (!is_valid_specialization(s)) {
+            return default_capacity;
+        }
+        lock_guard<mutex> guard(specialization[s]->lock);
+        return specialization[s]->capacity;
+    }
+
+    // Adds a patient to the waiting line of a specialization and wakes one waiting doctor
+    // Returns: The patient's new ID, or 0 if the specialization is unknown or full
+    int add_patient(int s, Patient patient) {
+        if (!is_valid_specialization(s)) {
+            return 0;
+        }
+        int id = next_patient_id.fetch_add(1);
+        patient.set_id(id);
+        {
+            // Registered first, so a doctor serving the patient right away finds the entry to erase
+            lock_guard<mutex> guard(registry_lock);
+            registry[id] = s;
+        }
+
+        Specialization& spec = *specialization[s];
+        {
+            lock_guard<mutex> guard(spec.lock);
+            if (spec.capacity == 0 || spec.waiting < spec.capacity) {
+                uint32_t handle = spec.patients.add(patient);
+                spec.queue.push(handle, patient.get_priority());
+                spec.handles[id] = handle;
+                ++spec.waiting;
+                log_added(s, patient);
+                spec.stats.arrivals[patient.get_priority()].fetch_add(1, memory_order_relaxed);
+                spec.stats.set_depth(spec.waiting);
+            }
+            else {
+                spec.stats.turned_away.fetch_add(1, memory_order_relaxed);
+                id = 0;
+            }
+        }
+        if (id == 0) {
+            forget(patient.get_id());
+            return 0;
+        }
+        spec.arrived.notify_one();
+        return id;
+    }
+
+    // Looks up a waiting patient and the specialization they wait in
+    // Returns: False if no patient with that ID is waiting (unknown, served or cancelled)
+    bool find_patient(int id, Patient& patient, int& s) const {
+        s = locate(id);
+        if (s < 0) {
+            return false;
+        }
+        const Specialization& spec = *specialization[s];
+        lock_guard<mutex> guard(spec.lock);
+        auto it = spec.handles.find(id);
+        if (it == spec.handles.end()) {
+            return false;
+        }
+        patient = spec.patients.get(it->second);
+        return true;
+    }
+
+    // Removes a waiting patient; their queue slot becomes a tombstone that is
+    // skipped and freed when it reaches the front
+    // Returns: False if no patient with that ID is waiting
+    bool cancel_patient(int id) {
+        int s = locate(id);
+        if (s < 0) {
+            return false;
+        }
+        Specialization& spec = *specialization[s];
+        {
+            lock_guard<mutex> guard(spec.lock);
+            auto it = spec.handles.find(id);
+            if (it == spec.handles.end()) {
+                return false;
+            }
+            spec.patients.cancel(it->second);
+            spec.handles.erase(it);
+            --spec.waiting;
+            drop_cancelled(spec);
+            log_event(PATIENT_CANCELLED, id);
+            spec.stats.cancelled.fetch_add(1, memory_order_relaxed);
+            spec.stats.set_depth(spec.waiting);
+        }
+        forget(id);
+        return true;
+    }
+
+    // Moves a waiting patient to a higher triage level, behind those already there
+    // Returns: False if the patient is not waiting or already at that level or above
+    bool escalate_patient(int id, Priority priority) {
+        int s = locate(id);
+        if (s < 0) {
+            return false;
+        }
+        Specialization& spec = *specialization[s];
+        lock_guard<mutex> guard(spec.lock);
+        auto it = spec.handles.find(id);
+        if (it == spec.handles.end() || spec.patients.get(it->second).get_priority() >= priority) {
+            return false;
+        }
+        Patient patient = spec.patients.get(it->second);
+        patient.set_priority(priority);
+        spec.patients.cancel(it->second);
+        it->second = spec.patients.add(patient, spec.patients.arrival(it->second));
+        spec.queue.push(it->second, priority);
+        drop_cancelled(spec);
+        log_event(PATIENT_ESCALATED, id, priority);
+        spec.stats.escalated.fetch_add(1, memory_order_relaxed);
+        return true;
+    }
+
+    // Takes the next patient of a specialization without waiting
+    // Returns: False if the specialization is unknown or nobody is waiting
+    bool try_next_patient(int s, Patient& patient) {
+        if (!is_valid_specialization(s)) {
+            return false;
+        }
+        Specialization& spec = *specialization[s];
+        {
+            lock_guard<mutex> guard(spec.lock);
+            if (spec.waiting == 0) {
+                return false;
+            }
+            patient = take_front(spec);
+        }
+        forget(patient.get_id());
+        return true;
+    }
+
+    // Blocks until a patient is waiting in the specialization, then takes them
+    // Returns: False once the system is closed and the queue has drained
+    bool wait_next_patient(int s, Patient& patient) {
+        if (!is_valid_specialization(s)) {
+            return false;
+        }
+        Specialization& spec = *specialization[s];
+        {
+            unique_lock<mutex> guard(spec.lock);
+            spec.arrived.wait(guard, [&] { return spec.waiting > 0 || closed.load(); });
+            if (spec.waiting == 0) {
+                return false;
+            }
+            patient = take_front(spec);
+        }
+        forget(patient.get_id());
+        return true;
+    }
+
+    // Stops accepting waits: doctors finish the patients already queued, then return
+    void close() {
+        closed.store(true);
+        for (auto& spec : specialization) {
+            if (spec) {
+                // Taking the lock orders the flag with a doctor that is about to wait
+                lock_guard<mutex> guard(spec->lock);
+                spec->arrived.notify_all();
+            }
+        }
+    }
+
+    // Writes the counters and wait-time percentiles of every specialization as JSON
+    // Reads only atomics, so it can run while desks and doctors keep working
+    void export_stats(ostream& out) const {
+        static const char* levels[PRIORITY_LEVELS] = {"regular", "urgent", "critical"};
+
+        auto per_level = [&](const array<atomic<uint64_t>, PRIORITY_LEVELS>& counts) {
+            out << "{";
+            for (int p = 0; p < PRIORITY_LEVELS; ++p) {
+                out << (p ? ", " : "") << "\"" << levels[p] << "\": " << counts[p].load(memory_order_relaxed);
+            }
+            out << "}";
+        };
+
+        out << "{\n  \"specializations\": [";
+        bool first = true;
+        for (int s = 0; s < (int)specialization.size(); ++s) {
+            if (!specialization[s]) {
+                continue;
+            }
+            const QueueStats& stats = specialization[s]->stats;
+            out << (first ? "" : ",") << "\n    {\"id\": " << s
+                << ", \"depth\": " << stats.depth.load(memory_order_relaxed)
+                << ", \"max_depth\": " << stats.max_depth.load(memory_order_relaxed)
+                << ", \"cancelled\": " << stats.cancelled.load(memory_order_relaxed)
+                << ", \"escalated\": " << stats.escalated.load(memory_order_relaxed)
+                << ", \"turned_away\": " << stats.turned_away.load(memory_order_relaxed)
+                << ",\n     \"arrivals\": ";
+            per_level(stats.arrivals);
+            out << ",\n     \"served\": ";
+            per_level(stats.served);
+            out << ",\n     \"wait_us\": {";
+            for (int p = 0; p < PRIORITY_LEVELS; ++p) {
+                const WaitHistogram& wait = stats.wait_us[p];
+                out << (p ? ",\n                 " : "") << "\"" << levels[p] << "\": {"
+                    << "\"count\": " << wait.samples()
+                    << ", \"mean\": " << wait.mean()
+                    << ", \"p50\": " << wait.percentile(0.50)
+                    << ", \"p90\": " << wait.percentile(0.90)
+                    << ", \"p99\": " << wait.percentile(0.99)
+                    << ", \"max\": " << wait.maximum() << "}";
+            }
+            out << "}}";
+            first = false;
+        }
+        out << "\n  ]\n}\n";
+    }
+
+    // Writes every waiting patient to a new checkpoint (atomically) and empties the log
+    // Holds every specialization lock meanwhile, so the checkpoint is consistent
+    bool checkpoint() {
+        if (!events) {
+            return false;
+        }
+        vector<unique_lock<mutex>> guards;
+        for (auto& spec : specialization) {
+            if (spec) {
+                guards.emplace_back(spec->lock);
+            }
+        }
+
+        RecordWriter body;
+        uint32_t count = 0;
+        for (int s = 0; s < (int)specialization.size(); ++s) {
+            if (!specialization[s]) {
+                continue;
+            }
+            const Specialization& spec = *specialization[s];
+            body.i32(s);
+            body.u32(static_cast<uint32_t>(spec.capacity));
+            body.u32(static_cast<uint32_t>(spec.waiting));
+            spec.queue.for_each([&](uint32_t handle) {
+                if (!spec.patients.is_cancelled(handle)) {
+                    write_patient(body, spec.patients.get(handle));
+                }
+            });
+            ++count;
+        }
+
+        RecordWriter header;
+        header.u8('H'); header.u8('O'); header.u8('S'); header.u8('P');
+        header.u32(CHECKPOINT_VERSION);
+        header.i32(next_patient_id.load());
+        header.u32(count);
+        header.u32(checksum(body.data()));
+
+        // On disk before the rename, or a crash could leave an empty checkpoint next to an empty log
+        const string temp_path = checkpoint_path + ".tmp";
+        FILE* file = fopen(temp_path.c_str(), "wb");
+        bool written = file
+            && fwrite(header.data().data(), 1, header.data().size(), file) == header.data().size()
+            && fwrite(body.data().data(), 1, body.data().size(), file) == body.data().size()
+            && sync_to_disk(file);
+        if (file) {
+            fclose(file);
+        }
+        if (!written) {
+            cout << "Unable to write checkpoint file: " << temp_path << "\n";
+            return false;
+        }
+        error_code error;
+        filesystem::rename(temp_path, checkpoint_path, error);
+        if (error) {
+            cout << "Unable to replace checkpoint file: " << checkpoint_path << "\n";
+            return false;
+        }
+
+        // The checkpoint now holds everything the log did
+        events->reset();
+        return true;
+    }
+
+    // Blocks until every change made so far is on disk; call before confirming a change
+    // Returns: False if a change may not survive a restart; report that instead of success
+    bool sync_store() {
+        return !events || events->sync();
+    }
+
+    // Checkpoints once the log has grown past the threshold, which bounds replay time
+    void checkpoint_if_needed() {
+        if (events && events->size() >= checkpoint_records) {
+            checkpoint();
+        }
+    }
+
+    // Loads the last checkpoint, replays the event log on top of it, then logs every later change
+    // Must be called before desks or doctors start; returns false if the checkpoint is unreadable
+    bool open_store(const string& checkpoint_file = "hospital.checkpoint", const string& log_file = "hospital.log",
+        size_t checkpoint_every = 10000) {
+        checkpoint_path = checkpoint_file;
+        checkpoint_records = checkpoint_every;
+        if (!load_checkpoint()) {
+            return false;
+        }
+
+        // Replayed before the log is attached, so replaying does not log again
+        auto log = make_unique<EventLog>();
+        if (!log->open(log_file, [&](RecordReader& record) { apply_event(record); })) {
+            return false;
+        }
+        events = move(log);
+        checkpoint_if_needed();
+        return true;
+    }
+
+    // Checkpoints and detaches the log, so the next start has nothing to replay
+    void close_store() {
+        if (events) {
+            checkpoint();
+            events->close();
+            events.reset();
+        }
+    }
+
+    // Runs registration desks and doctors as threads against the
+    // shared queues. Desks stop after patients_per_desk patients; doctor i serves
+    // specialization 1 + i % N and leaves once the line is closed and empty.
+    void simulate(int desks, int doctors, int patients_per_desk) {
+        int served_specializations = min<int>(doctors, (int)specialization.size() - 1);
+        if (desks <= 0 || doctors <= 0 || served_specializations <= 0) {
+            cout << "Nothing to simulate.\n";
+            return;
+        }
+        closed.store(false);
+
+        atomic<long long> added{0}, turned_away{0}, served{0};
+        auto start = chrono::steady_clock::now();
+
+        vector<thread> doctor_threads;
+        for (int d = 0; d < doctors; ++d) {
+            doctor_threads.emplace_back([&, d] {
+                int s = 1 + d % served_specializations;
+                Patient patient;
+                while (wait_next_patient(s, patient)) {
+                    served.fetch_add(1, memory_order_relaxed);
+                }
+            });
+        }
+
+        vector<thread> desk_threads;
+        for (int k = 0; k < desks; ++k) {
+            desk_threads.emplace_back([&, k] {
+                mt19937 rng(k + 1);
+                for (int i = 0; i < patients_per_desk; ++i) {
+                    Priority priority = static_cast<Priority>(rng() % PRIORITY_LEVELS);
+                    Patient patient("desk" + to_string(k) + "_" + to_string(i), 20 + rng() % 60, "-", "-", priority);
+                    int s = 1 + rng() % served_specializations;
+                    if (add_patient(s, patient)) {
+                        added.fetch_add(1, memory_order_relaxed);
+                    }
+                    else {
+                        turned_away.fetch_add(1, memory_order_relaxed);
+                    }
+                }
+            });
+        }
+
+        for (thread& t : desk_threads) {
+            t.join();
+        }
+        close();
+        for (thread& t : doctor_threads) {
+            t.join();
+        }
+        closed.store(false);
+
+        double ms = chrono::duration<double, milli>(chrono::steady_clock::now() - start).count();
+        cout << "Desks: " << desks << ", Doctors: " << doctors
+            << ", Specializations: " << served_specializations << "\n";
+        cout << "Added: " << added << ", Turned away (full): " << turned_away
+            << ", Served: " << served << "\n";
+        cout << "Elapsed: " << fixed << setprecision(1) << ms << " ms\n";
+    }
+
     void add_new_patient() {
         print_separator();
         cout << "\nEnter Patient Details:\n";
@@ -63,22 +1293,56 @@ public:
         string address;
         cin >> address;
 
-        cout << "Status (0 for Regular, 1 for Urgent): ";
-        bool statu;
+        cout << "Status (0 for Regular, 1 for Urgent, 2 for Critical): ";
+        int statu;
         cin >> statu;
+        if (statu < REGULAR || statu >= PRIORITY_LEVELS) {
+            cout << "\nInvalid status! Please enter 0, 1 or 2.\n";
+            return;
+        }
 
-        Patient patient(name, age, phone, address, statu);
+        Patient patient(name, age, phone, address, static_cast<Priority>(statu));
 
         cout << "Specialization: ";
         int s;
         cin >> s;
 
-        if ((int)specialization[s].size() < 5) {
-            (statu == 0) ? specialization[s].push_front(patient) : specialization[s].push_back(patient);
-            cout << "\nPatient added successfully!\n";
+        if (!is_valid_specialization(s)) {
+            cout << "\nUnknown specialization! Registered specializations: " << list_specializations() << ".\n";
+        }
+        else if (int id = add_patient(s, patient)) {
+            if (sync_store()) {
+                cout << "\nPatient added successfully! Patient ID: " << id << "\n";
+            }
+            else {
+                cout << "\nPatient added with ID " << id << ", but it could not be saved and will be lost on restart!\n";
+            }
+        }
+        else {
+            cout << "\nSorry, we can't add more than " << get_capacity(s) << " patients in this specialization.\n";
+        }
+    }
+
+    void set_specialization_capacity() {
+        print_separator();
+        cout << "\nSpecialization: ";
+        int s;
+        cin >> s;
+
+        cout << "Maximum waiting patients (0 for no limit): ";
+        size_t limit;
+        cin >> limit;
+
+        if (set_capacity(s, limit)) {
+            if (sync_store()) {
+                cout << "\nCapacity updated successfully!\n";
+            }
+            else {
+                cout << "\nCapacity updated, but it could not be saved and will be lost on restart!\n";
+            }
         }
         else {
-            cout << "\nSorry, we can't add more than 5 patients in this specialization.\n";
+            cout << "\nInvalid specialization!\n";
         }
     }
 
@@ -86,14 +1350,28 @@ public:
         print_separator();
         cout << "\nAll Patients in the System:\n";
 
-        for (auto& pair : specialization) {
-            cout << "\nSpecialization " << pair.first << " (" << pair.second.size() << " patients):\n";
-
-            for (int i = 0; i < (int)pair.second.size(); ++i) {
-                cout << "  " << i + 1 << ") Name: " << pair.second[i].get_name()
-                    << ", Age: " << pair.second[i].get_age()
-                    << ", Status: " << pair.second[i].get_statu() << "\n";
+        for (int s = 0; s < (int)specialization.size(); ++s) {
+            if (!specialization[s]) {
+                continue;
+            }
+            const Specialization& spec = *specialization[s];
+            lock_guard<mutex> guard(spec.lock);
+            if (spec.waiting == 0) {
+                continue;
             }
+            cout << "\nSpecialization " << s << " (" << spec.waiting << " patients):\n";
+
+            int i = 0;
+            spec.queue.for_each([&](uint32_t handle) {
+                if (spec.patients.is_cancelled(handle)) {
+                    return;
+                }
+                const Patient& patient = spec.patients.get(handle);
+                cout << "  " << ++i << ") ID: " << patient.get_id()
+                    << ", Name: " << patient.get_name()
+                    << ", Age: " << patient.get_age()
+                    << ", Status: " << patient.get_statu() << "\n";
+            });
         }
     }
 
@@ -103,12 +1381,102 @@ public:
         int s;
         cin >> s;
 
-        if (specialization[s].empty()) {
+        Patient patient;
+        if (!is_valid_specialization(s)) {
+            cout << "\nInvalid specialization!\n";
+        }
+        else if (!try_next_patient(s, patient)) {
             cout << "\nNo patients at the moment. Have a rest, Dr. Mohamed Reda.\n";
         }
         else {
-            cout << "\nNext Patient: " << specialization[s][0].get_name() << ". Please proceed to Dr. Mohamed Reda.\n";
-            specialization[s].pop_front();
+            if (sync_store()) {
+                cout << "\nNext Patient: " << patient.get_name() << ". Please proceed to Dr. Mohamed Reda.\n";
+            }
+            else {
+                cout << "\nNext Patient: " << patient.get_name() << ". Please proceed to Dr. Mohamed Reda.\n"
+                    << "This could not be saved; the patient will be back in line after a restart!\n";
+            }
+        }
+    }
+
+    void cancel_waiting_patient() {
+        print_separator();
+        cout << "\nPatient ID: ";
+        int id;
+        cin >> id;
+
+        if (cancel_patient(id)) {
+            if (sync_store()) {
+                cout << "\nPatient removed from the waiting line.\n";
+            }
+            else {
+                cout << "\nPatient removed, but it could not be saved and will be undone on restart!\n";
+            }
+        }
+        else {
+            cout << "\nNo waiting patient with this ID!\n";
+        }
+    }
+
+    void escalate_waiting_patient() {
+        print_separator();
+        cout << "\nPatient ID: ";
+        int id;
+        cin >> id;
+
+        cout << "New Status (1 for Urgent, 2 for Critical): ";
+        int statu;
+        cin >> statu;
+        if (statu <= REGULAR || statu >= PRIORITY_LEVELS) {
+            cout << "\nInvalid status! Please enter 1 or 2.\n";
+            return;
+        }
+
+        if (escalate_patient(id, static_cast<Priority>(statu))) {
+            if (sync_store()) {
+                cout << "\nPatient status updated successfully!\n";
+            }
+            else {
+                cout << "\nPatient status updated, but it could not be saved and will be undone on restart!\n";
+            }
+        }
+        else {
+            cout << "\nNo waiting patient with this ID and a lower status!\n";
+        }
+    }
+
+    void find_waiting_patient() {
+        print_separator();
+        cout << "\nPatient ID: ";
+        int id;
+        cin >> id;
+
+        Patient patient;
+        int s;
+        if (find_patient(id, patient, s)) {
+            cout << "\nName: " << patient.get_name()
+                << ", Age: " << patient.get_age()
+                << ", Status: " << patient.get_statu()
+                << ", Specialization: " << s << "\n";
+        }
+        else {
+            cout << "\nNo waiting patient with this ID!\n";
+        }
+    }
+
+    void export_statistics() {
+        print_separator();
+        cout << "\nFile name: ";
+        string path;
+        cin >> path;
+
+        ofstream file(path);
+        export_stats(file);
+        if (file) {
+            cout << "\nStatistics written to " << path << "\n";
+        }
+        else {
+            cout << "\nUnable to write " << path << "!\n";
         }
     }
 
@@ -120,10 +1488,18 @@ public:
             cout << "  2) Print All Patients\n";
             cout << "  3) Get Next Patient\n";
             cout << "  4) Exit\n";
+            // Options added later go after Exit, so existing numbers (and scripted input) keep working
+            cout << "  5) Set Specialization Capacity\n";
+            cout << "  6) Cancel Patient\n";
+            cout << "  7) Escalate Patient\n";
+            cout << "  8) Find Patient\n";
+            cout << "  9) Export Statistics\n";
             cout << "\nEnter your choice: ";
 
             int choice;
-            cin >> choice;
+            if (!(cin >> choice)) {
+                return;
+            }
 
             switch (choice) {
             case 1:
@@ -137,17 +1513,157 @@ public:
                 break;
             case 4:
                 cout << "\nExiting the system. Goodbye!\n";
-                exit(0);
+                return;
+            case 5:
+                set_specialization_capacity();
+                break;
+            case 6:
+                cancel_waiting_patient();
+                break;
+            case 7:
+                escalate_waiting_patient();
+                break;
+            case 8:
+                find_waiting_patient();
+                break;
+            case 9:
+                export_statistics();
+                break;
             default:
-                cout << "\nInvalid choice! Please enter a number between 1 and 4.\n";
+                cout << "\nInvalid choice! Please enter a number between 1 and 9.\n";
                 break;
             }
+            checkpoint_if_needed();
         }
     }
 };
 
-int main() {
+// Times single operations and reports their throughput and latency percentiles
+class LatencyRecorder {
+private:
+    string name;
+    vector<double> samples;     // Nanoseconds
+
+public:
+    explicit LatencyRecorder(string name) : name(move(name)) {
+        samples.reserve(1 << 16);
+    }
+
+    template <class Work>
+    void measure(Work work) {
+        auto start = chrono::steady_clock::now();
+        work();
+        samples.push_back(chrono::duration<double, nano>(chrono::steady_clock::now() - start).count());
+    }
+
+    // Same columns as the AskMe and library benchmarks, so their output can be compared
+    static void print_header(ostream& out) {
+        out << left << setw(28) << "Operation" << right << setw(10) << "Count" << setw(14) << "Ops/sec"
+            << setw(10) << "p50 us" << setw(10) << "p90 us" << setw(10) << "p99 us" << setw(10) << "Max us" << "\n";
+    }
+
+    void print(ostream& out) const {
+        if (samples.empty()) {
+            return;
+        }
+        vector<double> sorted = samples;
+        sort(sorted.begin(), sorted.end());
+        double total_ns = accumulate(sorted.begin(), sorted.end(), 0.0);
+        auto at = [&](double fraction) {
+            return sorted[min(sorted.size() - 1, static_cast<size_t>(fraction * sorted.size()))] / 1000.0;
+        };
+        out << left << setw(28) << name << right << setw(10) << sorted.size()
+            << fixed << setprecision(0) << setw(14) << sorted.size() / (total_ns / 1e9)
+            << setprecision(2) << setw(10) << at(0.50) << setw(10) << at(0.90) << setw(10) << at(0.99)
+            << setw(10) << sorted.back() / 1000.0 << "\n";
+        out.unsetf(ios::floatfield);
+    }
+};
+
+// Times enqueue, dequeue, cancel and escalate one call at a time, first in
+// memory and then with the event log attached, on synthetic patients from a
+// fixed seed; finishes with a concurrent desks/doctors run
+void run_benchmark(size_t patient_count, int specialization_count) {
+    const filesystem::path scratch = filesystem::temp_directory_path() / "hospital-benchmark";
+    filesystem::create_directories(scratch);
+
+    for (bool persistent : {false, true}) {
+        HospitalSystem hospital(specialization_count, 0);
+        if (persistent) {
+            hospital.open_store((scratch / "hospital.checkpoint").string(), (scratch / "hospital.log").string(),
+                patient_count * 10);
+        }
+        mt19937 rng(42);
+        const string suffix = persistent ? " (logged)" : "";
+        LatencyRecorder enqueue("add_patient" + suffix), dequeue("try_next_patient" + suffix),
+            cancel("cancel_patient" + suffix), escalate("escalate_patient" + suffix);
+
+        vector<int> ids;
+        for (size_t i = 0; i < patient_count; ++i) {
+            Patient patient("patient" + to_string(i), 20 + rng() % 60, "0100000000", "Cairo",
+                static_cast<Priority>(rng() % PRIORITY_LEVELS));
+            int s = 1 + rng() % specialization_count;
+            enqueue.measure([&] { ids.push_back(hospital.add_patient(s, patient)); });
+        }
+        shuffle(ids.begin(), ids.end(), rng);
+        // A tenth of the line leaves early and another tenth is escalated
+        for (size_t i = 0; i < ids.size() / 10; ++i) {
+            cancel.measure([&] { hospital.cancel_patient(ids[i]); });
+        }
+        for (size_t i = ids.size() / 10; i < ids.size() / 5; ++i) {
+            escalate.measure([&] { hospital.escalate_patient(ids[i], CRITICAL); });
+        }
+        Patient patient;
+        for (int s = 1; s <= specialization_count; ++s) {
+            bool served = true;
+            while (served) {
+                dequeue.measure([&] { served = hospital.try_next_patient(s, patient); });
+            }
+        }
+
+        if (!persistent) {
+            cout << "Patients: " << patient_count << ", specializations: " << specialization_count << "\n";
+            LatencyRecorder::print_header(cout);
+        }
+        for (const LatencyRecorder* recorder : {&enqueue, &dequeue, &cancel, &escalate}) {
+            recorder->print(cout);
+        }
+    }
+    filesystem::remove_all(scratch);
+
+    cout << "\nConcurrent run:\n";
+    HospitalSystem hospital(specialization_count, 0);
+    hospital.simulate(4, specialization_count, static_cast<int>(patient_count / 4));
+}
+
+// Usage: Hospital_System [--simulate <desks> <doctors> <patients per desk> [capacity]]
+//                        [--benchmark [patients] [specializations]]
+int main(int argc, char* argv[]) {
+    if (argc >= 2 && string(argv[1]) == "--benchmark") {
+        size_t patients = argc >= 3 ? strtoul(argv[2], nullptr, 10) : 200000;
+        int specializations = argc >= 4 ? max(1, atoi(argv[3])) : 20;
+        run_benchmark(patients, specializations);
+        return 0;
+    }
+
     HospitalSystem hospital;
+
+    if (argc >= 5 && string(argv[1]) == "--simulate") {
+        if (argc >= 6) {
+            size_t limit = strtoul(argv[5], nullptr, 10);
+            for (int s = 1; hospital.is_valid_specialization(s); ++s) {
+                hospital.set_capacity(s, limit);
+            }
+        }
+        hospital.simulate(atoi(argv[2]), atoi(argv[3]), atoi(argv[4]));
+        return 0;
+    }
+
+    if (!hospital.open_store()) {
+        // An empty waiting room would hand out patient IDs again and log nothing
+        cout << "Refusing to start: repair or move aside hospital.checkpoint and hospital.log.\n";
+        return 1;
+    }
     hospital.run();
 
     return 0;
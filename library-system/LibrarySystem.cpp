@@ -1,4 +1,9 @@
 #include <bits/stdc++.h>
+#ifdef _WIN32
+#include <io.h>
+#else
+#include <unistd.h>
+#endif
 using namespace std;
 
 enum class SortOption {
@@ -6,25 +11,116 @@ enum class SortOption {
     NAME
 };
 
+// Visits one page of a sorted view: skips `offset` entries, then at most `limit` (0 = all)
+// Skipping walks the view, so a deep page costs O(offset); prefer forEachAfter() for streaming
+template <class View, class Visit>
+void forEachInPage(const View& view, size_t offset, size_t limit, Visit visit) {
+    auto it = view.begin();
+    advance(it, min(offset, view.size()));
+    for (size_t n = 0; it != view.end() && (limit == 0 || n < limit); ++it, ++n) {
+        visit(*it);
+    }
+}
+
+// Visits one page of a sorted view: the entries after the key `after` (null = from the start),
+// at most `limit` of them (0 = all); any page costs O(log n + limit)
+template <class View, class Visit>
+void forEachAfter(const View& view, const typename View::key_type* after, size_t limit, Visit visit) {
+    auto it = after ? view.upper_bound(*after) : view.begin();
+    for (size_t n = 0; it != view.end() && (limit == 0 || n < limit); ++it, ++n) {
+        visit(*it);
+    }
+}
+
+// Outcome of a batch operation: nothing is applied unless every item is valid
+struct BatchResult {
+    bool applied = false;
+    size_t processed = 0;                 // Items applied
+    vector<pair<size_t, string>> errors;  // (item index, reason) for each rejected item
+
+    void reject(size_t index, string reason) {
+        errors.emplace_back(index, move(reason));
+    }
+};
+
+// The title is shared, so copying a Book never copies the string and
+// books from a TitlePool share one copy of each distinct title
 class Book {
 private:
     int id {};
-    string name {};
+    shared_ptr<const string> name;
+
+    static const shared_ptr<const string>& emptyName() {
+        static const shared_ptr<const string> empty = make_shared<const string>();
+        return empty;
+    }
 
 public:
-    Book() {}
-    Book(int id, string name) : id(id), name(name) {}
-    Book(const Book& other) : id(other.id), name(other.name) {}
+    Book() : name(emptyName()) {}
+    Book(int id, string name) : id(id), name(make_shared<const string>(move(name))) {}
+    Book(int id, shared_ptr<const string> name) : id(id), name(name ? move(name) : emptyName()) {}
 
     int getId() const {
         return id;
     }
 
-    string getName() const {
+    const string& getName() const {
+        return *name;
+    }
+
+    const shared_ptr<const string>& getSharedName() const {
         return name;
     }
 };
 
+// Interns book titles: each distinct title is stored once, however many books carry it
+class TitlePool {
+private:
+    unordered_map<string_view, shared_ptr<const string>> titles; // Keys point into the values
+
+public:
+    shared_ptr<const string> intern(string_view title) {
+        auto it = titles.find(title);
+        if (it != titles.end()) {
+            return it->second;
+        }
+        auto shared = make_shared<const string>(title);
+        titles.emplace(*shared, shared);
+        return shared;
+    }
+
+    Book makeBook(int id, string_view title) {
+        return Book(id, intern(title));
+    }
+
+    // Drops the titles no book uses any more
+    void releaseUnused() {
+        for (auto it = titles.begin(); it != titles.end();) {
+            it = it->second.use_count() == 1 ? titles.erase(it) : next(it);
+        }
+    }
+
+    size_t size() const {
+        return titles.size();
+    }
+};
+
+class User;
+
+// Receives every change made to the library state, in order
+// LibraryStore implements it to keep an append-only change log on disk
+class ChangeLog {
+public:
+    virtual ~ChangeLog() = default;
+    virtual void bookAdded(const Book& book, int totalQuantity) = 0;
+    virtual void bookUpdated(int bookId, const Book& book) = 0;
+    virtual void quantityAdjusted(int bookId, int delta) = 0;
+    virtual void userRegistered(const User& user) = 0;
+    virtual void userUpdated(int userId, const User& user) = 0;
+    virtual void bookBorrowed(int bookId, int userId) = 0;
+    virtual void bookReturned(int bookId, int userId) = 0;
+};
+
 class BookInfo {
 private:
     Book book;
@@ -63,10 +159,48 @@ public:
 class BookInventory {
 private:
     unordered_map<int, BookInfo> inventory;
+    // Sorted (name, id) pairs for prefix search; the views point into the
+    // names stored in `inventory`, whose nodes never move
+    set<pair<string_view, int>> nameIndex;
+    set<int> idIndex;
+    unordered_multimap<string_view, int> idsByName; // Exact name -> book IDs
+    ChangeLog* changeLog = nullptr;
+
+    void indexName(int bookId, string_view name) {
+        nameIndex.emplace(name, bookId);
+        idsByName.emplace(name, bookId);
+    }
+
+    void unindexName(int bookId, string_view name) {
+        nameIndex.erase({name, bookId});
+        auto [first, last] = idsByName.equal_range(name);
+        for (auto it = first; it != last; ++it) {
+            if (it->second == bookId) {
+                idsByName.erase(it);
+                break;
+            }
+        }
+    }
 
 public:
+    void setChangeLog(ChangeLog* log) {
+        changeLog = log;
+    }
+
     void addBook(const Book& book, int total_quantity) {
-        inventory.emplace(book.getId(), BookInfo(book, total_quantity));
+        auto [it, inserted] = inventory.emplace(book.getId(), BookInfo(book, total_quantity));
+        if (inserted) {
+            indexName(book.getId(), it->second.getBook().getName());
+            idIndex.insert(book.getId());
+            if (changeLog) {
+                changeLog->bookAdded(book, total_quantity);
+            }
+        }
+    }
+
+    void reserve(size_t count) {
+        inventory.reserve(inventory.size() + count);
+        idsByName.reserve(idsByName.size() + count);
     }
 
     BookInfo& getBookInfo(int bookId) {
@@ -81,10 +215,23 @@ public:
         return inventory;
     }
 
-    void updateBookInfo(int bookId, const Book& updatedInfo) {
+    // Quiet version of updateBookInfo; returns false if there is no such book
+    bool setBook(int bookId, const Book& updatedInfo) {
         auto it = inventory.find(bookId);
-        if (it != inventory.end()) {
-            it->second.setBook(updatedInfo);
+        if (it == inventory.end()) {
+            return false;
+        }
+        unindexName(bookId, it->second.getBook().getName());
+        it->second.setBook(updatedInfo);
+        indexName(bookId, it->second.getBook().getName());
+        if (changeLog) {
+            changeLog->bookUpdated(bookId, updatedInfo);
+        }
+        return true;
+    }
+
+    void updateBookInfo(int bookId, const Book& updatedInfo) {
+        if (setBook(bookId, updatedInfo)) {
             cout << "Book information has been updated successfully!\n";
         } else {
             cout << "There is no book with this ID. Please try again!\n";
@@ -100,6 +247,9 @@ public:
         auto it = inventory.find(bookId);
         if (it != inventory.end()) {
             it->second.adjustQuantity(delta);
+            if (changeLog) {
+                changeLog->quantityAdjusted(bookId, delta);
+            }
         } else {
             cout << "Book not found in inventory!\n";
         }
@@ -108,6 +258,97 @@ public:
     bool bookExists(int bookId) const {
         return inventory.find(bookId) != inventory.end();
     }
+
+    // One page of books in ID or name order, walked straight off the sorted views
+    vector<const BookInfo*> getBooks(SortOption sortBy, size_t offset = 0, size_t limit = 0) const {
+        vector<const BookInfo*> res;
+        if (sortBy == SortOption::ID) {
+            forEachInPage(idIndex, offset, limit, [&](int id) {
+                res.push_back(&inventory.at(id));
+            });
+        } else {
+            forEachInPage(nameIndex, offset, limit, [&](const pair<string_view, int>& entry) {
+                res.push_back(&inventory.at(entry.second));
+            });
+        }
+        return res;
+    }
+
+    // One page of books in ID or name order, starting after the book `afterId` (nullopt = first page)
+    // Pass the ID of the last book on a page to get the next one; a cursor naming no book gives an empty page
+    vector<const BookInfo*> getBooksAfter(SortOption sortBy, optional<int> afterId, size_t limit) const {
+        vector<const BookInfo*> res;
+        if (sortBy == SortOption::ID) {
+            forEachAfter(idIndex, afterId ? &*afterId : nullptr, limit, [&](int id) {
+                res.push_back(&inventory.at(id));
+            });
+            return res;
+        }
+        optional<pair<string_view, int>> after;
+        if (afterId) {
+            auto it = inventory.find(*afterId);
+            if (it == inventory.end()) {
+                return res;
+            }
+            after.emplace(it->second.getBook().getName(), *afterId);
+        }
+        forEachAfter(nameIndex, after ? &*after : nullptr, limit, [&](const pair<string_view, int>& entry) {
+            res.push_back(&inventory.at(entry.second));
+        });
+        return res;
+    }
+
+    // IDs of the books named exactly `name`, in ID order
+    vector<int> findByName(string_view name) const {
+        vector<int> ids;
+        auto [first, last] = idsByName.equal_range(name);
+        for (auto it = first; it != last; ++it) {
+            ids.push_back(it->second);
+        }
+        sort(ids.begin(), ids.end());
+        return ids;
+    }
+
+    // Books whose name starts with `prefix`, in name order, without copying them
+    // Skips the first `offset` matches and returns at most `limit` (0 = no limit)
+    vector<const Book*> findByPrefix(string_view prefix, size_t limit = 0, size_t offset = 0) const {
+        vector<const Book*> res;
+        for (auto it = nameIndex.lower_bound({prefix, INT_MIN});
+             it != nameIndex.end() && it->first.substr(0, prefix.size()) == prefix; ++it) {
+            if (offset > 0) {
+                --offset;
+                continue;
+            }
+            if (limit != 0 && res.size() == limit) {
+                break;
+            }
+            res.push_back(&inventory.at(it->second).getBook());
+        }
+        return res;
+    }
+
+    // Same matches as findByPrefix(), paged by cursor: starts after the book `afterId` (nullopt = first page)
+    vector<const Book*> findByPrefixAfter(string_view prefix, optional<int> afterId, size_t limit) const {
+        vector<const Book*> res;
+        auto it = nameIndex.lower_bound({prefix, INT_MIN});
+        if (afterId) {
+            auto book = inventory.find(*afterId);
+            if (book == inventory.end()) {
+                return res;
+            }
+            pair<string_view, int> after(book->second.getBook().getName(), *afterId);
+            if (it == nameIndex.end() || after >= *it) {
+                it = nameIndex.upper_bound(after);
+            }
+        }
+        for (; it != nameIndex.end() && it->first.substr(0, prefix.size()) == prefix; ++it) {
+            if (limit != 0 && res.size() == limit) {
+                break;
+            }
+            res.push_back(&inventory.at(it->second).getBook());
+        }
+        return res;
+    }
 };
 
 class BookService {
@@ -126,6 +367,32 @@ public:
         cout << "Book added successfully!\n";
     }
 
+    // Adds (book, total quantity) pairs all-or-nothing, without printing
+    BatchResult addBooks(const vector<pair<Book, int>>& books) {
+        BatchResult result;
+        unordered_set<int> seen;
+        seen.reserve(books.size());
+        for (size_t i = 0; i < books.size(); ++i) {
+            int id = books[i].first.getId();
+            if (bookInventory.bookExists(id) || !seen.insert(id).second) {
+                result.reject(i, "Duplicate book ID " + to_string(id));
+            } else if (books[i].second < 0) {
+                result.reject(i, "Negative quantity for book ID " + to_string(id));
+            }
+        }
+        if (!result.errors.empty()) {
+            return result;
+        }
+
+        bookInventory.reserve(books.size());
+        for (const auto& [book, total_quantity] : books) {
+            bookInventory.addBook(book, total_quantity);
+        }
+        result.applied = true;
+        result.processed = books.size();
+        return result;
+    }
+
     void readAndAddBook() {
         cout << "Enter Book info: \n";
         
@@ -146,46 +413,28 @@ public:
         addBook(book, total_quantity);
     }
 
-    void listBooks(SortOption sortBy) {
-        auto inventory = bookInventory.getInventory();
-        vector<pair<int, const BookInfo*>> books;
-        
-        for (const auto& item : inventory) {
-            books.push_back({item.first, &item.second});
-        }
-        
-        if (sortBy == SortOption::ID) {
-            sort(books.begin(), books.end(),
-                [](const auto& a, const auto& b) {
-                    return a.first < b.first;
-                });
-        } else if (sortBy == SortOption::NAME) {
-            sort(books.begin(), books.end(),
-                [](const auto& a, const auto& b) {
-                    return a.second->getBook().getName() < b.second->getBook().getName();
-                });
-        } else {
+    // Prints one page of the catalog (limit 0 = everything from `offset` on)
+    void listBooks(SortOption sortBy, size_t offset = 0, size_t limit = 0) const {
+        if (sortBy != SortOption::ID && sortBy != SortOption::NAME) {
             cout << "Invalid sort option!\n";
             return;
         }
         
-        for (const auto& book : books) {
-            cout << "ID: " << book.second->getBook().getId()
-                << "\tName: " << book.second->getBook().getName()
-                << "\tTotal Quantity: " << book.second->getTotalQuantity()
-                << "\tTotal Borrowed: " << book.second->getTotalBorrowed() << '\n';
+        for (const BookInfo* book : bookInventory.getBooks(sortBy, offset, limit)) {
+            cout << "ID: " << book->getBook().getId()
+                << "\tName: " << book->getBook().getName()
+                << "\tTotal Quantity: " << book->getTotalQuantity()
+                << "\tTotal Borrowed: " << book->getTotalBorrowed() << '\n';
         }
     }
 
-    vector<Book> searchBooksByPrefix(const string& prefix) const {
-        vector<Book> res;
-        for (const auto& book : bookInventory.getInventory()) { // It's better to ask BookInventory to return its Books
-            const string& bookName = book.second.getBook().getName();
-            if (bookName.size() >= prefix.size() && bookName.substr(0, prefix.size()) == prefix) {
-                res.push_back(book.second.getBook());
-            }
-        }
-        return res;
+    // Pointers stay valid until the inventory changes
+    vector<const Book*> searchBooksByPrefix(const string& prefix, size_t limit = 0, size_t offset = 0) const {
+        return bookInventory.findByPrefix(prefix, limit, offset);
+    }
+
+    vector<const Book*> searchBooksByPrefixAfter(const string& prefix, optional<int> afterId, size_t limit) const {
+        return bookInventory.findByPrefixAfter(prefix, afterId, limit);
     }
 
     void readAndSearchBooksByPrefix() {
@@ -193,7 +442,7 @@ public:
         string prefix;
         cin >> prefix;
         
-        vector<Book> books = searchBooksByPrefix(prefix);
+        vector<const Book*> books = searchBooksByPrefix(prefix);
         
         if (books.empty()) {
             cout << "No books found with the prefix \"" << prefix << "\".\n";
@@ -202,7 +451,7 @@ public:
         
         cout << "Books matching prefix \"" << prefix << "\":\n";
         for (size_t i = 0; i < books.size(); ++i) {
-            cout << i + 1 << ") ID: " << books[i].getId() << " - Name: " << books[i].getName() << '\n';
+            cout << i + 1 << ") ID: " << books[i]->getId() << " - Name: " << books[i]->getName() << '\n';
         }
     }
 };
@@ -214,14 +463,13 @@ private:
 
 public:
     User() {}
-    User(int id, string name) : id(id), name(name) {}
-    User(const User& other) : id(other.id), name(other.name) {}
+    User(int id, string name) : id(id), name(move(name)) {}
 
     int getId() const {
         return id;
     }
 
-    string getName() const {
+    const string& getName() const {
         return name;
     }
     
@@ -241,49 +489,168 @@ namespace std {
 
 class UserService {
 private:
-    vector<User> users;
+    deque<User> users; // deque, so registering never moves existing users
+    // Sorted views over `users`, holding positions in it
+    set<pair<int, size_t>> idView;
+    set<pair<string_view, size_t>> nameView; // Views point into the stored names
+    unordered_map<int, size_t> idToPos;      // User ID -> position in `users`
+    ChangeLog* changeLog = nullptr;
+
+    void indexUser(size_t pos) {
+        idView.emplace(users[pos].getId(), pos);
+        nameView.emplace(users[pos].getName(), pos);
+    }
+
+    void unindexUser(size_t pos) {
+        idView.erase({users[pos].getId(), pos});
+        nameView.erase({users[pos].getName(), pos});
+    }
+
+    // Stores a user whose ID is already reserved in idToPos
+    void addUser(const User& user) {
+        users.push_back(user);
+        indexUser(users.size() - 1);
+        if (changeLog) {
+            changeLog->userRegistered(user);
+        }
+    }
 
 public:
-    void listUsers(SortOption sortOption) const {
-        cout << "All Users in the system: \n";
-        vector<User> sortedUsers = users;
+    void setChangeLog(ChangeLog* log) {
+        changeLog = log;
+    }
 
+    // One page of users in ID or name order, walked straight off the sorted views
+    vector<const User*> getUsers(SortOption sortOption, size_t offset = 0, size_t limit = 0) const {
+        vector<const User*> res;
+        auto visit = [&](const auto& entry) {
+            res.push_back(&users[entry.second]);
+        };
         if (sortOption == SortOption::ID) {
-            sort(sortedUsers.begin(), sortedUsers.end(),
-                [](const User& a, const User& b) {
-                    return a.getId() < b.getId();
-                });
-        } else if (sortOption == SortOption::NAME) {
-            sort(sortedUsers.begin(), sortedUsers.end(),
-                [](const User& a, const User& b) {
-                    return a.getName() < b.getName();
-                });
+            forEachInPage(idView, offset, limit, visit);
         } else {
+            forEachInPage(nameView, offset, limit, visit);
+        }
+        return res;
+    }
+
+    // One page of users in ID or name order, starting after the user `afterId` (nullopt = first page)
+    // Pass the ID of the last user on a page to get the next one; a cursor naming no user gives an empty page
+    vector<const User*> getUsersAfter(SortOption sortOption, optional<int> afterId, size_t limit) const {
+        vector<const User*> res;
+        auto visit = [&](const auto& entry) {
+            res.push_back(&users[entry.second]);
+        };
+        if (sortOption == SortOption::ID) {
+            // Positions only break ties between equal IDs, and IDs are unique
+            optional<pair<int, size_t>> after;
+            if (afterId) {
+                after.emplace(*afterId, numeric_limits<size_t>::max());
+            }
+            forEachAfter(idView, after ? &*after : nullptr, limit, visit);
+            return res;
+        }
+        optional<pair<string_view, size_t>> after;
+        if (afterId) {
+            auto it = idToPos.find(*afterId);
+            if (it == idToPos.end()) {
+                return res;
+            }
+            after.emplace(users[it->second].getName(), it->second);
+        }
+        forEachAfter(nameView, after ? &*after : nullptr, limit, visit);
+        return res;
+    }
+
+    // Prints one page of users (limit 0 = everything from `offset` on)
+    void listUsers(SortOption sortOption, size_t offset = 0, size_t limit = 0) const {
+        cout << "All Users in the system: \n";
+        if (sortOption != SortOption::ID && sortOption != SortOption::NAME) {
             cout << "Invalid sort option!\n";
             return;
         }
 
-        for (size_t i = 0; i < sortedUsers.size(); ++i)
-            cout << i + 1 << ") " << sortedUsers[i].getName() << '\n';
+        size_t i = offset;
+        for (const User* user : getUsers(sortOption, offset, limit))
+            cout << ++i << ") " << user->getName() << '\n';
     }
 
-    void updateUserDetails(int userId, const User& updatedInfo) {
-        auto it = find_if(users.begin(), users.end(),
-            [userId](const User& user) {
-                return user.getId() == userId;
-            });
+    // Quiet version of updateUserDetails; returns false if the user is
+    // missing or the new ID is already taken
+    bool replaceUser(int userId, const User& updatedInfo) {
+        auto it = idToPos.find(userId);
+        if (it == idToPos.end()) {
+            return false;
+        }
 
-        if (it != users.end()) {
-            *it = updatedInfo;
-            cout << "User details updated successfully!\n";
-        } else {
+        size_t pos = it->second;
+        if (updatedInfo.getId() != userId) {
+            if (!idToPos.emplace(updatedInfo.getId(), pos).second) {
+                return false;
+            }
+            idToPos.erase(userId);
+        }
+        unindexUser(pos);
+        users[pos] = updatedInfo;
+        indexUser(pos);
+        if (changeLog) {
+            changeLog->userUpdated(userId, updatedInfo);
+        }
+        return true;
+    }
+
+    void updateUserDetails(int userId, const User& updatedInfo) {
+        if (!userExist(userId)) {
             cout << "User not found!\n";
+        } else if (!replaceUser(userId, updatedInfo)) {
+            cout << "User ID already exists!\n";
+        } else {
+            cout << "User details updated successfully!\n";
         }
     }
 
-    void registerUser(const User& user) {
-        users.push_back(user);
+    // Quiet version of registerUser
+    bool tryRegisterUser(const User& user) {
+        if (!idToPos.emplace(user.getId(), users.size()).second) {
+            return false;
+        }
+        addUser(user);
+        return true;
+    }
+
+    // Returns false (and changes nothing) if the ID is already taken
+    bool registerUser(const User& user) {
+        if (!tryRegisterUser(user)) {
+            cout << "User ID already exists!\n";
+            return false;
+        }
         cout << "User registered successfully!\n";
+        return true;
+    }
+
+    // Registers users all-or-nothing, without printing
+    BatchResult registerUsers(const vector<User>& newUsers) {
+        BatchResult result;
+        unordered_set<int> seen;
+        seen.reserve(newUsers.size());
+        for (size_t i = 0; i < newUsers.size(); ++i) {
+            int id = newUsers[i].getId();
+            if (idToPos.count(id) || !seen.insert(id).second) {
+                result.reject(i, "Duplicate user ID " + to_string(id));
+            }
+        }
+        if (!result.errors.empty()) {
+            return result;
+        }
+
+        idToPos.reserve(idToPos.size() + newUsers.size());
+        for (const User& user : newUsers) {
+            idToPos.emplace(user.getId(), users.size());
+            addUser(user);
+        }
+        result.applied = true;
+        result.processed = newUsers.size();
+        return result;
     }
 
     void readAndRegisterUser() {
@@ -303,19 +670,12 @@ public:
     }
 
     bool userExist(int user_id) const {
-        for (const auto& user : users) {
-            if (user.getId() == user_id)
-                return true;
-        }
-        return false;
+        return idToPos.count(user_id) != 0;
     }
     
     const User* getUserById(int user_id) const {
-        for (const auto& user : users) {
-            if (user.getId() == user_id)
-                return &user;
-        }
-        return nullptr;
+        auto it = idToPos.find(user_id);
+        return it == idToPos.end() ? nullptr : &users[it->second];
     }
 };
 
@@ -324,13 +684,100 @@ private:
     struct BorrowRecord {
         int userId;
         int bookId;
+        // Links of the per-user and per-book loan lists (-1 = none)
+        // A free slot reuses nextByUser as the free list link
+        int prevByUser = -1, nextByUser = -1;
+        int prevByBook = -1, nextByBook = -1;
         BorrowRecord(int userId, int bookId) : userId(userId), bookId(bookId) {}
     };
 
+    // Ends of one intrusive loan list, oldest loan first
+    struct LoanList {
+        int head = -1;
+        int tail = -1;
+    };
+
     BookInventory& bookInventory;
     UserService& userService;
-    vector<BorrowRecord> borrowRecords;
+    vector<BorrowRecord> borrowRecords; // Record pool; returned slots are reused
+    int freeSlot = -1;                  // First free slot in the pool
+    unordered_map<int, LoanList> loansByUser;
+    unordered_map<int, LoanList> loansByBook;
+    unordered_multimap<long long, int> loanSlots; // (user, book) -> slot, one per copy borrowed
+    ChangeLog* changeLog = nullptr;
+
+    static long long loanKey(int userId, int bookId) {
+        return (static_cast<long long>(userId) << 32) | static_cast<unsigned int>(bookId);
+    }
+
+    void link(LoanList& list, int slot, int BorrowRecord::*prev, int BorrowRecord::*next) {
+        BorrowRecord& record = borrowRecords[slot];
+        record.*prev = list.tail;
+        record.*next = -1;
+        (list.tail != -1 ? borrowRecords[list.tail].*next : list.head) = slot;
+        list.tail = slot;
+    }
+
+    void unlink(LoanList& list, int slot, int BorrowRecord::*prev, int BorrowRecord::*next) {
+        BorrowRecord& record = borrowRecords[slot];
+        (record.*prev != -1 ? borrowRecords[record.*prev].*next : list.head) = record.*next;
+        (record.*next != -1 ? borrowRecords[record.*next].*prev : list.tail) = record.*prev;
+    }
+
+    // Visits the records of one loan list, oldest first
+    template <class Visit>
+    void forEachLoan(const unordered_map<int, LoanList>& lists, int key, int BorrowRecord::*next, Visit visit) const {
+        auto it = lists.find(key);
+        if (it == lists.end()) {
+            return;
+        }
+        for (int slot = it->second.head; slot != -1; slot = borrowRecords[slot].*next) {
+            visit(borrowRecords[slot]);
+        }
+    }
+
+    void addLoan(int userId, int bookId) {
+        int slot;
+        if (freeSlot != -1) {
+            slot = freeSlot;
+            freeSlot = borrowRecords[slot].nextByUser;
+            borrowRecords[slot] = BorrowRecord(userId, bookId);
+        } else {
+            slot = static_cast<int>(borrowRecords.size());
+            borrowRecords.emplace_back(userId, bookId);
+        }
+        link(loansByUser[userId], slot, &BorrowRecord::prevByUser, &BorrowRecord::nextByUser);
+        link(loansByBook[bookId], slot, &BorrowRecord::prevByBook, &BorrowRecord::nextByBook);
+        loanSlots.emplace(loanKey(userId, bookId), slot);
+        if (changeLog) {
+            changeLog->bookBorrowed(bookId, userId);
+        }
+    }
+
+    void removeLoan(int slot) {
+        const BorrowRecord& record = borrowRecords[slot];
+        auto userList = loansByUser.find(record.userId);
+        unlink(userList->second, slot, &BorrowRecord::prevByUser, &BorrowRecord::nextByUser);
+        if (userList->second.head == -1) {
+            loansByUser.erase(userList);
+        }
+        auto bookList = loansByBook.find(record.bookId);
+        unlink(bookList->second, slot, &BorrowRecord::prevByBook, &BorrowRecord::nextByBook);
+        if (bookList->second.head == -1) {
+            loansByBook.erase(bookList);
+        }
+        if (changeLog) {
+            changeLog->bookReturned(record.bookId, record.userId);
+        }
+        borrowRecords[slot].nextByUser = freeSlot;
+        freeSlot = slot;
+    }
+
 public:
+    void setChangeLog(ChangeLog* log) {
+        changeLog = log;
+    }
+
     LoanService(BookInventory& inventory, UserService& users)
         : bookInventory(inventory), userService(users) {}
 
@@ -350,12 +797,79 @@ public:
             return false;
         }
 
-        borrowRecords.emplace_back(userId, bookId);
+        addLoan(userId, bookId);
         bookInventory.getBookInfo(bookId).adjustBorrowed(1);
         cout << "Book borrowed successfully!\n";
         return true;
     }
 
+    struct LoanRequest {
+        int bookId;
+        int userId;
+    };
+
+    // Borrows every requested book all-or-nothing, without printing
+    // Availability accounts for earlier requests in the same batch
+    BatchResult borrowBooks(const vector<LoanRequest>& requests) {
+        BatchResult result;
+        unordered_map<int, int> requestedCopies;
+        for (size_t i = 0; i < requests.size(); ++i) {
+            const LoanRequest& request = requests[i];
+            if (!bookInventory.bookExists(request.bookId)) {
+                result.reject(i, "Unknown book ID " + to_string(request.bookId));
+            } else if (!userService.userExist(request.userId)) {
+                result.reject(i, "Unknown user ID " + to_string(request.userId));
+            } else {
+                const BookInfo& info = bookInventory.getBookInfo(request.bookId);
+                int& copies = requestedCopies[request.bookId];
+                if (info.getTotalBorrowed() + ++copies > info.getTotalQuantity()) {
+                    result.reject(i, "No copies left of book ID " + to_string(request.bookId));
+                }
+            }
+        }
+        if (!result.errors.empty()) {
+            return result;
+        }
+
+        borrowRecords.reserve(borrowRecords.size() + requests.size());
+        loanSlots.reserve(loanSlots.size() + requests.size());
+        for (const LoanRequest& request : requests) {
+            addLoan(request.userId, request.bookId);
+        }
+        for (const auto& [bookId, copies] : requestedCopies) {
+            bookInventory.getBookInfo(bookId).adjustBorrowed(copies);
+        }
+        result.applied = true;
+        result.processed = requests.size();
+        return result;
+    }
+
+    // Returns every requested loan all-or-nothing, without printing
+    BatchResult returnBooks(const vector<LoanRequest>& requests) {
+        BatchResult result;
+        unordered_map<long long, size_t> requestedReturns;
+        for (size_t i = 0; i < requests.size(); ++i) {
+            long long key = loanKey(requests[i].userId, requests[i].bookId);
+            if (++requestedReturns[key] > loanSlots.count(key)) {
+                result.reject(i, "No loan of book ID " + to_string(requests[i].bookId) +
+                    " by user ID " + to_string(requests[i].userId));
+            }
+        }
+        if (!result.errors.empty()) {
+            return result;
+        }
+
+        for (const LoanRequest& request : requests) {
+            auto it = loanSlots.find(loanKey(request.userId, request.bookId));
+            removeLoan(it->second);
+            loanSlots.erase(it);
+            bookInventory.getBookInfo(request.bookId).adjustBorrowed(-1);
+        }
+        result.applied = true;
+        result.processed = requests.size();
+        return result;
+    }
+
     void readAndBorrowBook() {
         cout << "Enter User ID: ";
         int userId;
@@ -369,22 +883,50 @@ public:
     }
     
     bool returnBook(int bookId, int userId) {
-        auto it = find_if(borrowRecords.begin(), borrowRecords.end(),
-            [bookId, userId](const BorrowRecord& record) {
-                return record.bookId == bookId && record.userId == userId;
-            });
-        
-        if (it == borrowRecords.end()) {
+        if (!releaseLoan(bookId, userId)) {
             cout << "No record found of this user borrowing this book.\n";
             return false;
         }
         
-        borrowRecords.erase(it);
-        bookInventory.getBookInfo(bookId).adjustBorrowed(-1);
         cout << "Book returned successfully!\n";
         return true;
     }
 
+    // Quiet version of returnBook
+    bool releaseLoan(int bookId, int userId) {
+        auto it = loanSlots.find(loanKey(userId, bookId));
+        if (it == loanSlots.end()) {
+            return false;
+        }
+        removeLoan(it->second);
+        loanSlots.erase(it);
+        bookInventory.getBookInfo(bookId).adjustBorrowed(-1);
+        return true;
+    }
+
+    // Records a loan read back from storage, skipping the availability check
+    // (the saved state may have had its quantity reduced below the copies on loan)
+    bool restoreLoan(int bookId, int userId) {
+        if (!bookInventory.bookExists(bookId)) {
+            return false;
+        }
+        addLoan(userId, bookId);
+        bookInventory.getBookInfo(bookId).adjustBorrowed(1);
+        return true;
+    }
+
+    // Every open loan, each user's loans oldest first
+    vector<LoanRequest> getLoans() const {
+        vector<LoanRequest> loans;
+        loans.reserve(loanSlots.size());
+        for (const auto& [userId, list] : loansByUser) {
+            forEachLoan(loansByUser, userId, &BorrowRecord::nextByUser, [&](const BorrowRecord& record) {
+                loans.push_back({record.bookId, record.userId});
+            });
+        }
+        return loans;
+    }
+
     void readAndReturnBook() {
         cout << "Enter User ID: ";
         int userId;
@@ -399,24 +941,22 @@ public:
     
     vector<Book> listLoansForUser(int userId) const {
         vector<Book> books;
-        for (const auto& record : borrowRecords) {
-            if (record.userId == userId && bookInventory.bookExists(record.bookId)) {
+        forEachLoan(loansByUser, userId, &BorrowRecord::nextByUser, [&](const BorrowRecord& record) {
+            if (bookInventory.bookExists(record.bookId)) {
                 books.push_back(bookInventory.getBookInfo(record.bookId).getBook());
             }
-        }
+        });
         return books;
     }
 
     vector<User> listBorrowers(int bookId) const {
         vector<User> res;
-        for (const auto& borrowRecord : borrowRecords) {
-            if (borrowRecord.bookId == bookId) {
-                const User* user = userService.getUserById(borrowRecord.userId);
-                if (user) {
-                    res.push_back(*user);
-                }
+        forEachLoan(loansByBook, bookId, &BorrowRecord::nextByBook, [&](const BorrowRecord& record) {
+            const User* user = userService.getUserById(record.userId);
+            if (user) {
+                res.push_back(*user);
             }
-        }
+        });
         return res;
     }
     
@@ -442,16 +982,12 @@ public:
     }
     
     void printBorrowersByBookName(const string& bookName) const {
-        bool found = false;
-        for (const auto& item : bookInventory.getInventory()) {
-            const Book& book = item.second.getBook();
-            if (book.getName() == bookName) {
-                printBorrowersByBookId(book.getId());
-                found = true;
-            }
+        vector<int> bookIds = bookInventory.findByName(bookName);
+        for (int bookId : bookIds) {
+            printBorrowersByBookId(bookId);
         }
         
-        if (!found) {
+        if (bookIds.empty()) {
             cout << "No book with name \"" << bookName << "\" found in the inventory.\n";
         }
     }
@@ -497,34 +1033,511 @@ public:
     }
 };
 
-class LibraryManager {
+// Saves the whole library to a binary snapshot and logs every change after it
+// Startup is one sequential read of each file; the log is folded into a new
+// snapshot once it grows past `compactThreshold` records
+//
+// Snapshot: "LIBS", version, book/user/loan counts, FNV-1a checksum of the body, then
+//           books (id, quantity, name), users (id, name), loans (book id, user id)
+// Log:      records of (payload length, type, fields); a torn last record is ignored
+// Integers are 32-bit little-endian, strings are length-prefixed
+class LibraryStore : public ChangeLog {
 private:
-    BookInventory inventory;
-    BookService bookService;
-    UserService userService;
-    LoanService loanService;
-    AdminService adminService;
-    bool running;
+    static constexpr uint32_t SNAPSHOT_VERSION = 2;
+
+    enum RecordType : uint8_t {
+        BOOK_ADDED = 1,
+        BOOK_UPDATED,
+        QUANTITY_ADJUSTED,
+        USER_REGISTERED,
+        USER_UPDATED,
+        BOOK_BORROWED,
+        BOOK_RETURNED
+    };
 
-public:
-    LibraryManager() :
-        bookService(inventory),
-        loanService(inventory, userService),
-        adminService(userService, bookService),
-        running(true) {}
+    class Writer {
+    private:
+        string bytes;
 
-    void displayMenu() const {
-        cout << "\n========================================\n";
-        cout << "              Library Menu              \n";
-        cout << "========================================\n";
-        cout << setw(2) << "1)" << " Add Book\n";
-        cout << setw(2) << "2)" << " Search Books by Prefix\n";
-        cout << setw(2) << "3)" << " Print Who Borrowed Book by Name\n";
-        cout << setw(2) << "4)" << " Print Library by ID\n";
-        cout << setw(2) << "5)" << " Print Library by Name\n";
-        cout << setw(2) << "6)" << " Add User\n";
-        cout << setw(2) << "7)" << " User Borrow Book\n";
-        cout << setw(2) << "8)" << " User Return Book\n";
+    public:
+        void u8(uint8_t value) {
+            bytes += static_cast<char>(value);
+        }
+
+        void u32(uint32_t value) {
+            for (int i = 0; i < 4; ++i) {
+                bytes += static_cast<char>(value >> (8 * i));
+            }
+        }
+
+        void i32(int value) {
+            u32(static_cast<uint32_t>(value));
+        }
+
+        void str(const string& value) {
+            u32(static_cast<uint32_t>(value.size()));
+            bytes += value;
+        }
+
+        const string& data() const {
+            return bytes;
+        }
+    };
+
+    class Reader {
+    private:
+        string_view bytes;
+        bool good = true;
+
+    public:
+        explicit Reader(string_view bytes) : bytes(bytes) {}
+
+        uint8_t u8() {
+            if (bytes.empty()) {
+                good = false;
+                return 0;
+            }
+            uint8_t value = static_cast<uint8_t>(bytes[0]);
+            bytes.remove_prefix(1);
+            return value;
+        }
+
+        uint32_t u32() {
+            if (bytes.size() < 4) {
+                good = false;
+                bytes = {};
+                return 0;
+            }
+            uint32_t value = 0;
+            for (int i = 0; i < 4; ++i) {
+                value |= uint32_t(static_cast<uint8_t>(bytes[i])) << (8 * i);
+            }
+            bytes.remove_prefix(4);
+            return value;
+        }
+
+        int i32() {
+            return static_cast<int>(u32());
+        }
+
+        string str() {
+            uint32_t size = u32();
+            if (bytes.size() < size) {
+                good = false;
+                bytes = {};
+                return "";
+            }
+            string value(bytes.substr(0, size));
+            bytes.remove_prefix(size);
+            return value;
+        }
+
+        string_view take(size_t size) {
+            if (bytes.size() < size) {
+                good = false;
+                bytes = {};
+                return {};
+            }
+            string_view value = bytes.substr(0, size);
+            bytes.remove_prefix(size);
+            return value;
+        }
+
+        bool ok() const {
+            return good;
+        }
+
+        bool done() const {
+            return bytes.empty();
+        }
+
+        size_t remaining() const {
+            return bytes.size();
+        }
+    };
+
+    string snapshotPath;
+    string logPath;
+    size_t compactThreshold;
+    ofstream logFile;
+    size_t logRecords = 0;
+    uint32_t generation = 0; // Stamped on the snapshot and on every log record written after it
+    bool unreadable = false; // The snapshot or log failed to load; never overwrite them
+
+    static uint32_t checksum(string_view data) {
+        uint32_t hash = 2166136261u;
+        for (char c : data) {
+            hash = (hash ^ static_cast<uint8_t>(c)) * 16777619u;
+        }
+        return hash;
+    }
+
+    // Pushes a stream's buffered bytes through the OS cache onto the disk
+    static bool syncToDisk(FILE* file) {
+        if (fflush(file) != 0) {
+            return false;
+        }
+#ifdef _WIN32
+        return _commit(_fileno(file)) == 0;
+#else
+        return fsync(fileno(file)) == 0;
+#endif
+    }
+
+    static bool readFile(const string& path, string& contents) {
+        ifstream file(path, ios::binary);
+        if (!file) {
+            return false;
+        }
+        contents.assign(istreambuf_iterator<char>(file), istreambuf_iterator<char>());
+        return true;
+    }
+
+    void append(const Writer& record) {
+        if (!logFile.is_open()) {
+            return; // Not attached (e.g. while loading)
+        }
+        Writer payload;
+        payload.u32(generation);
+        string bytes = payload.data() + record.data();
+        Writer framed;
+        framed.u32(static_cast<uint32_t>(bytes.size()));
+        framed.u32(checksum(bytes));
+        bytes = framed.data() + bytes;
+        logFile.write(bytes.data(), bytes.size());
+        logFile.flush();
+        ++logRecords;
+    }
+
+    bool loadSnapshot(BookInventory& inventory, UserService& users, LoanService& loans) {
+        string contents;
+        if (!readFile(snapshotPath, contents)) {
+            return true; // No snapshot yet
+        }
+        Reader in(contents);
+        if (in.take(4) != "LIBS" || in.u32() != SNAPSHOT_VERSION) {
+            cout << "Unrecognized snapshot file: " << snapshotPath << '\n';
+            return false;
+        }
+        uint32_t snapshotGeneration = in.u32();
+        uint32_t bookCount = in.u32(), userCount = in.u32(), loanCount = in.u32();
+        uint32_t expected = in.u32();
+        string_view bodyBytes = string_view(contents).substr(contents.size() - in.remaining());
+        Reader body(bodyBytes);
+        if (!in.ok() || checksum(bodyBytes) != expected) {
+            cout << "Corrupted snapshot file: " << snapshotPath << '\n';
+            return false;
+        }
+
+        // Decode everything before touching the services, so a bad body leaves them empty
+        vector<pair<Book, int>> books;
+        vector<User> allUsers;
+        vector<LoanService::LoanRequest> allLoans;
+        for (uint32_t i = 0; i < bookCount && body.ok(); ++i) {
+            int id = body.i32();
+            int quantity = body.i32();
+            books.emplace_back(Book(id, body.str()), quantity);
+        }
+        for (uint32_t i = 0; i < userCount && body.ok(); ++i) {
+            int id = body.i32();
+            allUsers.emplace_back(id, body.str());
+        }
+        for (uint32_t i = 0; i < loanCount && body.ok(); ++i) {
+            int bookId = body.i32();
+            allLoans.push_back({bookId, body.i32()});
+        }
+        if (!body.ok() || !body.done()) {
+            cout << "Corrupted snapshot file: " << snapshotPath << '\n';
+            return false;
+        }
+
+        generation = snapshotGeneration;
+        inventory.reserve(books.size());
+        for (const auto& [book, quantity] : books) {
+            inventory.addBook(book, quantity);
+        }
+        for (const User& user : allUsers) {
+            users.tryRegisterUser(user);
+        }
+        for (const auto& loan : allLoans) {
+            loans.restoreLoan(loan.bookId, loan.userId);
+        }
+        return true;
+    }
+
+    // Applies the log records written since the snapshot; returns false if a record before
+    // the last one is damaged, since skipping it would silently lose or misapply changes
+    bool replayLog(BookInventory& inventory, UserService& users, LoanService& loans) {
+        string contents;
+        if (!readFile(logPath, contents)) {
+            return true;
+        }
+        Reader in(contents);
+        while (!in.done()) {
+            size_t recordStart = contents.size() - in.remaining();
+            uint32_t size = in.u32();
+            uint32_t expected = in.u32();
+            string_view payload = in.take(size);
+            if (!in.ok() || checksum(payload) != expected) {
+                if (in.ok() && !in.done()) {
+                    cout << "Corrupted record in " << logPath << '\n';
+                    return false;
+                }
+                // Cut the torn record off, so new records are appended after the last good one
+                cout << "Ignoring an incomplete record at the end of " << logPath << '\n';
+                error_code error;
+                filesystem::resize_file(logPath, recordStart, error);
+                break;
+            }
+            ++logRecords;
+            Reader record(payload);
+            if (record.u32() < generation) {
+                continue; // Already in the snapshot: a compaction stopped before emptying the log
+            }
+            int id = 0, other = 0;
+            switch (record.u8()) {
+                case BOOK_ADDED: {
+                    id = record.i32();
+                    int quantity = record.i32();
+                    inventory.addBook(Book(id, record.str()), quantity);
+                    break;
+                }
+                case BOOK_UPDATED: {
+                    id = record.i32();
+                    other = record.i32();
+                    inventory.setBook(id, Book(other, record.str()));
+                    break;
+                }
+                case QUANTITY_ADJUSTED:
+                    id = record.i32();
+                    if (inventory.bookExists(id)) {
+                        inventory.getBookInfo(id).adjustQuantity(record.i32());
+                    }
+                    break;
+                case USER_REGISTERED:
+                    id = record.i32();
+                    users.tryRegisterUser(User(id, record.str()));
+                    break;
+                case USER_UPDATED:
+                    id = record.i32();
+                    other = record.i32();
+                    users.replaceUser(id, User(other, record.str()));
+                    break;
+                case BOOK_BORROWED:
+                    id = record.i32();
+                    loans.restoreLoan(id, record.i32());
+                    break;
+                case BOOK_RETURNED:
+                    id = record.i32();
+                    loans.releaseLoan(id, record.i32());
+                    break;
+                default:
+                    cout << "Skipping an unknown record in " << logPath << '\n';
+                    continue;
+            }
+            if (!record.ok() || !record.done()) {
+                cout << "Corrupted record in " << logPath << '\n';
+                return false;
+            }
+        }
+        return true;
+    }
+
+public:
+    LibraryStore(const string& snapshotPath = "library.snapshot", const string& logPath = "library.log",
+        size_t compactThreshold = 100000)
+        : snapshotPath(snapshotPath), logPath(logPath), compactThreshold(compactThreshold) {}
+
+    // Loads the snapshot, replays the log on top of it, then records every later change
+    // The services must be empty; returns false if the snapshot or the log is unreadable, after
+    // which saveSnapshot() refuses to replace the files (a bad snapshot leaves the services empty)
+    bool open(BookInventory& inventory, UserService& users, LoanService& loans) {
+        if (!loadSnapshot(inventory, users, loans) || !replayLog(inventory, users, loans)) {
+            unreadable = true;
+            return false;
+        }
+
+        logFile.open(logPath, ios::binary | ios::app);
+        inventory.setChangeLog(this);
+        users.setChangeLog(this);
+        loans.setChangeLog(this);
+        if (logRecords >= compactThreshold) {
+            saveSnapshot(inventory, users, loans);
+        }
+        return true;
+    }
+
+    // Writes the whole state to a new snapshot (atomically) and empties the log
+    // The snapshot's generation is one past the log's, so if the log survives a crash its records are skipped
+    bool saveSnapshot(const BookInventory& inventory, const UserService& users, const LoanService& loans) {
+        if (unreadable) {
+            return false; // Keep the existing files for recovery
+        }
+        const auto& books = inventory.getInventory();
+        vector<const User*> allUsers = users.getUsers(SortOption::ID);
+        vector<LoanService::LoanRequest> allLoans = loans.getLoans();
+
+        Writer body;
+        for (const auto& [id, info] : books) {
+            body.i32(id);
+            body.i32(info.getTotalQuantity());
+            body.str(info.getBook().getName());
+        }
+        for (const User* user : allUsers) {
+            body.i32(user->getId());
+            body.str(user->getName());
+        }
+        for (const auto& loan : allLoans) {
+            body.i32(loan.bookId);
+            body.i32(loan.userId);
+        }
+
+        Writer header;
+        header.u8('L'); header.u8('I'); header.u8('B'); header.u8('S');
+        header.u32(SNAPSHOT_VERSION);
+        header.u32(generation + 1);
+        header.u32(static_cast<uint32_t>(books.size()));
+        header.u32(static_cast<uint32_t>(allUsers.size()));
+        header.u32(static_cast<uint32_t>(allLoans.size()));
+        header.u32(checksum(body.data()));
+
+        const string tempPath = snapshotPath + ".tmp";
+        // Sync before the rename, so a crash cannot leave a snapshot that was never written out
+        FILE* file = fopen(tempPath.c_str(), "wb");
+        bool written = file && fwrite(header.data().data(), 1, header.data().size(), file) == header.data().size()
+            && fwrite(body.data().data(), 1, body.data().size(), file) == body.data().size()
+            && syncToDisk(file);
+        if (file && fclose(file) != 0) {
+            written = false;
+        }
+        if (!written) {
+            cout << "Unable to write snapshot file: " << tempPath << '\n';
+            return false;
+        }
+        error_code error;
+        filesystem::rename(tempPath, snapshotPath, error);
+        if (error) {
+            cout << "Unable to replace snapshot file: " << snapshotPath << '\n';
+            return false;
+        }
+
+        // The snapshot now holds everything the log did
+        ++generation;
+        bool attached = logFile.is_open();
+        logFile.close();
+        logFile.open(logPath, ios::binary | ios::trunc);
+        if (!attached) {
+            logFile.close();
+        }
+        logRecords = 0;
+        return true;
+    }
+
+    // Saves a new snapshot if the log has grown past the threshold
+    bool compactIfNeeded(const BookInventory& inventory, const UserService& users, const LoanService& loans) {
+        return logRecords < compactThreshold || saveSnapshot(inventory, users, loans);
+    }
+
+    size_t getLogRecords() const {
+        return logRecords;
+    }
+
+    void bookAdded(const Book& book, int totalQuantity) override {
+        Writer record;
+        record.u8(BOOK_ADDED);
+        record.i32(book.getId());
+        record.i32(totalQuantity);
+        record.str(book.getName());
+        append(record);
+    }
+
+    void bookUpdated(int bookId, const Book& book) override {
+        Writer record;
+        record.u8(BOOK_UPDATED);
+        record.i32(bookId);
+        record.i32(book.getId());
+        record.str(book.getName());
+        append(record);
+    }
+
+    void quantityAdjusted(int bookId, int delta) override {
+        Writer record;
+        record.u8(QUANTITY_ADJUSTED);
+        record.i32(bookId);
+        record.i32(delta);
+        append(record);
+    }
+
+    void userRegistered(const User& user) override {
+        Writer record;
+        record.u8(USER_REGISTERED);
+        record.i32(user.getId());
+        record.str(user.getName());
+        append(record);
+    }
+
+    void userUpdated(int userId, const User& user) override {
+        Writer record;
+        record.u8(USER_UPDATED);
+        record.i32(userId);
+        record.i32(user.getId());
+        record.str(user.getName());
+        append(record);
+    }
+
+    void bookBorrowed(int bookId, int userId) override {
+        Writer record;
+        record.u8(BOOK_BORROWED);
+        record.i32(bookId);
+        record.i32(userId);
+        append(record);
+    }
+
+    void bookReturned(int bookId, int userId) override {
+        Writer record;
+        record.u8(BOOK_RETURNED);
+        record.i32(bookId);
+        record.i32(userId);
+        append(record);
+    }
+};
+
+class LibraryManager {
+private:
+    BookInventory inventory;
+    BookService bookService;
+    UserService userService;
+    LoanService loanService;
+    AdminService adminService;
+    LibraryStore store;
+    bool running;
+
+public:
+    LibraryManager(const string& snapshotPath = "library.snapshot", const string& logPath = "library.log") :
+        bookService(inventory),
+        loanService(inventory, userService),
+        adminService(userService, bookService),
+        store(snapshotPath, logPath),
+        running(true) {
+        if (!store.open(inventory, userService, loanService)) {
+            // Running on an empty library would replace the data that failed to load
+            cout << "Refusing to start: repair or move aside " << snapshotPath << " and " << logPath << ".\n";
+            running = false;
+        }
+    }
+
+    void displayMenu() const {
+        cout << "\n========================================\n";
+        cout << "              Library Menu              \n";
+        cout << "========================================\n";
+        cout << setw(2) << "1)" << " Add Book\n";
+        cout << setw(2) << "2)" << " Search Books by Prefix\n";
+        cout << setw(2) << "3)" << " Print Who Borrowed Book by Name\n";
+        cout << setw(2) << "4)" << " Print Library by ID\n";
+        cout << setw(2) << "5)" << " Print Library by Name\n";
+        cout << setw(2) << "6)" << " Add User\n";
+        cout << setw(2) << "7)" << " User Borrow Book\n";
+        cout << setw(2) << "8)" << " User Return Book\n";
         cout << setw(2) << "9)" << " Print Users\n";
         cout << setw(3) << "10)" << " Exit\n";
         cout << "========================================\n";
@@ -567,6 +1580,7 @@ public:
                     adminService.printUsers();
                     break;
                 case 10:
+                    store.saveSnapshot(inventory, userService, loanService);
                     cout << "Exiting the library system. Goodbye!\n";
                     running = false;
                     break;
@@ -574,6 +1588,7 @@ public:
                     cout << "Invalid choice. Please try again.\n";
                     break;
             }
+            store.compactIfNeeded(inventory, userService, loanService);
         }
     }
 };
@@ -620,14 +1635,91 @@ void testSearchBooksByPrefix() {
     bookService.addBook(Book(101, "C++ Primer"), 5);
     bookService.addBook(Book(102, "Effective C++"), 3);
     
-    vector<Book> results = bookService.searchBooksByPrefix("C++");
+    vector<const Book*> results = bookService.searchBooksByPrefix("C++");
     assert(!results.empty());
-    for (const auto& b : results) {
-        assert(b.getName().substr(0, 3) == "C++");
+    for (const Book* b : results) {
+        assert(b->getName().substr(0, 3) == "C++");
     }
     cout << "Passed: Search Books by Prefix" << endl;
 }
 
+void testSearchBooksByPrefixPaging() {
+    cout << "Test: Search Books by Prefix with Limit/Offset" << endl;
+    BookInventory inventory;
+    BookService bookService(inventory);
+    bookService.addBook(Book(101, "Data Structures"), 1);
+    bookService.addBook(Book(102, "Databases"), 1);
+    bookService.addBook(Book(103, "Data Mining"), 1);
+    bookService.addBook(Book(104, "Algorithms"), 1);
+
+    vector<const Book*> all = bookService.searchBooksByPrefix("Data");
+    assert(all.size() == 3);
+    assert(all[0]->getId() == 103 && all[1]->getId() == 101 && all[2]->getId() == 102); // Name order
+
+    vector<const Book*> page = bookService.searchBooksByPrefix("Data", 1, 1);
+    assert(page.size() == 1 && page[0]->getId() == 101);
+    assert(bookService.searchBooksByPrefix("Data", 0, 3).empty());
+    assert(bookService.searchBooksByPrefix("Zoology").empty());
+
+    // Cursor paging visits the same matches in the same order
+    vector<int> walked;
+    for (optional<int> after; ; ) {
+        vector<const Book*> next = bookService.searchBooksByPrefixAfter("Data", after, 2);
+        if (next.empty()) {
+            break;
+        }
+        for (const Book* book : next) {
+            walked.push_back(book->getId());
+        }
+        after = next.back()->getId();
+    }
+    assert((walked == vector<int>{103, 101, 102}));
+    assert(bookService.searchBooksByPrefixAfter("Data", 104, 0).size() == 3); // Cursor sorts before the matches
+
+    inventory.updateBookInfo(104, Book(104, "Data Science"));
+    assert(bookService.searchBooksByPrefix("Data").size() == 4);
+    assert(bookService.searchBooksByPrefix("Algo").empty());
+    cout << "Passed: Search Books by Prefix with Limit/Offset" << endl;
+}
+
+void testSortedViews() {
+    cout << "Test: Sorted Views" << endl;
+    BookInventory inventory;
+    BookService bookService(inventory);
+    bookService.addBook(Book(103, "Algorithms"), 2);
+    bookService.addBook(Book(101, "C++ Primer"), 5);
+    bookService.addBook(Book(102, "Effective C++"), 3);
+
+    vector<const BookInfo*> byId = inventory.getBooks(SortOption::ID);
+    assert(byId.size() == 3 && byId[0]->getBook().getId() == 101 && byId[2]->getBook().getId() == 103);
+    vector<const BookInfo*> page = inventory.getBooks(SortOption::NAME, 1, 1);
+    assert(page.size() == 1 && page[0]->getBook().getName() == "C++ Primer");
+
+    vector<const BookInfo*> afterFirst = inventory.getBooksAfter(SortOption::NAME, 103, 1);
+    assert(afterFirst.size() == 1 && afterFirst[0]->getBook().getId() == 101);
+    assert(inventory.getBooksAfter(SortOption::ID, 101, 0).size() == 2);
+    assert(inventory.getBooksAfter(SortOption::ID, nullopt, 1)[0]->getBook().getId() == 101);
+    assert(inventory.getBooksAfter(SortOption::NAME, 999, 0).empty());
+
+    inventory.updateBookInfo(103, Book(103, "Xenobiology"));
+    assert(inventory.getBooks(SortOption::NAME).back()->getBook().getId() == 103);
+
+    UserService userService;
+    userService.registerUser(User(2, "Bob"));
+    userService.registerUser(User(3, "Alice"));
+    userService.registerUser(User(1, "Carol"));
+    assert(userService.getUsers(SortOption::ID)[0]->getName() == "Carol");
+    assert(userService.getUsers(SortOption::NAME)[0]->getName() == "Alice");
+    assert(userService.getUsers(SortOption::NAME, 2).size() == 1);
+    assert(userService.getUsersAfter(SortOption::NAME, 3, 1)[0]->getName() == "Bob");
+    assert(userService.getUsersAfter(SortOption::ID, 1, 0).size() == 2);
+    assert(userService.getUsersAfter(SortOption::ID, 3, 0).empty());
+
+    userService.updateUserDetails(3, User(3, "Zed"));
+    assert(userService.getUsers(SortOption::NAME).back()->getName() == "Zed");
+    cout << "Passed: Sorted Views" << endl;
+}
+
 void testRegisterUser() {
     cout << "Test: Register User" << endl;
     UserService userService;
@@ -637,6 +1729,23 @@ void testRegisterUser() {
     cout << "Passed: Register User" << endl;
 }
 
+void testUserLookup() {
+    cout << "Test: User Lookup" << endl;
+    UserService userService;
+    assert(userService.registerUser(User(1, "Alice")));
+    assert(userService.registerUser(User(2, "Bob")));
+    assert(!userService.registerUser(User(1, "Impostor")));
+    assert(userService.getUserById(1)->getName() == "Alice");
+    assert(userService.getUsers(SortOption::ID).size() == 2);
+
+    userService.updateUserDetails(2, User(3, "Bob"));
+    assert(!userService.userExist(2) && userService.getUserById(3)->getName() == "Bob");
+    userService.updateUserDetails(3, User(1, "Bob"));
+    assert(userService.getUserById(1)->getName() == "Alice" && userService.userExist(3));
+    assert(userService.getUserById(42) == nullptr);
+    cout << "Passed: User Lookup" << endl;
+}
+
 void testBorrowAndReturnBook() {
     cout << "Test: Borrow and Return Book" << endl;
     BookInventory inventory;
@@ -661,6 +1770,216 @@ void testBorrowAndReturnBook() {
     cout << "Passed: Borrow and Return Book" << endl;
 }
 
+void testLoanLedger() {
+    cout << "Test: Loan Ledger" << endl;
+    BookInventory inventory;
+    BookService bookService(inventory);
+    UserService userService;
+    bookService.addBook(Book(101, "C++ Primer"), 5);
+    bookService.addBook(Book(102, "Effective C++"), 5);
+    bookService.addBook(Book(103, "Algorithms"), 5);
+    userService.registerUser(User(1, "Alice"));
+    userService.registerUser(User(2, "Bob"));
+
+    LoanService loanService(inventory, userService);
+    assert(loanService.borrowBook(101, 1));
+    assert(loanService.borrowBook(102, 1));
+    assert(loanService.borrowBook(103, 1));
+    assert(loanService.borrowBook(102, 2));
+    assert(loanService.borrowBook(102, 1)); // Second copy of the same book
+
+    assert(loanService.returnBook(102, 1));
+    vector<Book> aliceLoans = loanService.listLoansForUser(1);
+    assert(aliceLoans.size() == 3);
+    assert(aliceLoans[0].getId() == 101); // Oldest loan first
+
+    vector<User> borrowers = loanService.listBorrowers(102);
+    assert(borrowers.size() == 2 && borrowers[0].getId() + borrowers[1].getId() == 3);
+
+    assert(loanService.returnBook(102, 1));
+    assert(!loanService.returnBook(102, 1));
+    assert(loanService.borrowBook(101, 2)); // Reuses a freed slot
+    assert(loanService.listLoansForUser(2).size() == 2);
+    assert(loanService.listBorrowers(101).size() == 2);
+    assert(inventory.getBookInfo(102).getTotalBorrowed() == 1);
+    cout << "Passed: Loan Ledger" << endl;
+}
+
+void testFindByName() {
+    cout << "Test: Find Books by Name" << endl;
+    BookInventory inventory;
+    BookService bookService(inventory);
+    bookService.addBook(Book(102, "Dune"), 1);
+    bookService.addBook(Book(101, "Dune"), 1);
+    bookService.addBook(Book(103, "Dune Messiah"), 1);
+
+    assert(inventory.findByName("Dune") == vector<int>({101, 102}));
+    assert(inventory.findByName("Dun").empty());
+
+    inventory.updateBookInfo(102, Book(102, "Children of Dune"));
+    assert(inventory.findByName("Dune") == vector<int>({101}));
+    assert(inventory.findByName("Children of Dune") == vector<int>({102}));
+    cout << "Passed: Find Books by Name" << endl;
+}
+
+void testBatchOperations() {
+    cout << "Test: Batch Operations" << endl;
+    BookInventory inventory;
+    BookService bookService(inventory);
+    UserService userService;
+    LoanService loanService(inventory, userService);
+
+    BatchResult rejected = bookService.addBooks({{Book(101, "C++ Primer"), 1}, {Book(101, "Duplicate"), 1}});
+    assert(!rejected.applied && rejected.errors.size() == 1 && rejected.errors[0].first == 1);
+    assert(!inventory.bookExists(101)); // All-or-nothing
+
+    BatchResult books = bookService.addBooks({{Book(101, "C++ Primer"), 1}, {Book(102, "Effective C++"), 2}});
+    assert(books.applied && books.processed == 2 && inventory.bookExists(102));
+
+    assert(!userService.registerUsers({User(1, "Alice"), User(1, "Alice again")}).applied);
+    assert(userService.registerUsers({User(1, "Alice"), User(2, "Bob")}).applied);
+    assert(!userService.registerUsers({User(3, "Carol"), User(2, "Bob")}).applied);
+    assert(!userService.userExist(3));
+
+    // Book 101 has one copy, so the second request fails and nothing is borrowed
+    BatchResult tooMany = loanService.borrowBooks({{101, 1}, {102, 1}, {101, 2}});
+    assert(!tooMany.applied && tooMany.errors.size() == 1 && tooMany.errors[0].first == 2);
+    assert(inventory.getBookInfo(102).getTotalBorrowed() == 0);
+
+    assert(loanService.borrowBooks({{101, 1}, {102, 1}, {102, 2}}).applied);
+    assert(inventory.getBookInfo(102).getTotalBorrowed() == 2);
+    assert(!inventory.checkAvailability(101));
+
+    assert(!loanService.returnBooks({{102, 1}, {102, 1}}).applied); // Only one copy on loan
+    assert(loanService.listLoansForUser(1).size() == 2);
+    assert(loanService.returnBooks({{102, 1}, {101, 1}}).applied);
+    assert(loanService.listLoansForUser(1).empty() && inventory.checkAvailability(101));
+    cout << "Passed: Batch Operations" << endl;
+}
+
+void testPersistence() {
+    cout << "Test: Persistence" << endl;
+    const string snapshotPath = (filesystem::temp_directory_path() / "library-test.snapshot").string();
+    const string logPath = (filesystem::temp_directory_path() / "library-test.log").string();
+    filesystem::remove(snapshotPath);
+    filesystem::remove(logPath);
+
+    {
+        BookInventory inventory;
+        BookService bookService(inventory);
+        UserService userService;
+        LoanService loanService(inventory, userService);
+        LibraryStore store(snapshotPath, logPath);
+        assert(store.open(inventory, userService, loanService));
+
+        bookService.addBooks({{Book(101, "C++ Primer"), 2}, {Book(102, "Effective C++"), 1}});
+        userService.registerUsers({User(1, "Alice"), User(2, "Bob")});
+        loanService.borrowBook(101, 1);
+        loanService.borrowBook(102, 2);
+        store.saveSnapshot(inventory, userService, loanService);
+
+        // Changes after the snapshot only go to the log
+        inventory.updateBookInfo(102, Book(102, "More Effective C++"));
+        userService.registerUser(User(3, "Carol"));
+        loanService.returnBook(102, 2);
+        loanService.borrowBook(101, 3);
+        assert(store.getLogRecords() == 4);
+    }
+
+    BookInventory inventory;
+    UserService userService;
+    LoanService loanService(inventory, userService);
+    LibraryStore store(snapshotPath, logPath);
+    assert(store.open(inventory, userService, loanService));
+    assert(inventory.getBookInfo(102).getBook().getName() == "More Effective C++");
+    assert(inventory.getBookInfo(101).getTotalBorrowed() == 2);
+    assert(inventory.getBookInfo(102).getTotalBorrowed() == 0);
+    assert(userService.userExist(3));
+    assert(loanService.listLoansForUser(1).size() == 1 && loanService.listLoansForUser(2).empty());
+
+    // A torn record at the end of the log is ignored
+    {
+        ofstream log(logPath, ios::binary | ios::app);
+        log.write("\x20\0\0\0\x01", 5);
+    }
+    BookInventory reloaded;
+    UserService reloadedUsers;
+    LoanService reloadedLoans(reloaded, reloadedUsers);
+    LibraryStore reloadedStore(snapshotPath, logPath);
+    assert(reloadedStore.open(reloaded, reloadedUsers, reloadedLoans));
+    assert(reloaded.getBookInfo(101).getTotalBorrowed() == 2);
+    reloadedUsers.registerUser(User(4, "Dave")); // Logged after the cut
+    assert(reloadedStore.getLogRecords() == 5);
+
+    BookInventory afterCut;
+    UserService afterCutUsers;
+    LoanService afterCutLoans(afterCut, afterCutUsers);
+    LibraryStore afterCutStore(snapshotPath, logPath);
+    assert(afterCutStore.open(afterCut, afterCutUsers, afterCutLoans));
+    assert(afterCutUsers.userExist(4));
+
+    // A compaction that stopped before emptying the log does not replay it twice
+    const string oldLogPath = logPath + ".old";
+    afterCut.adjustQuantity(101, 3);
+    filesystem::copy_file(logPath, oldLogPath, filesystem::copy_options::overwrite_existing);
+    assert(afterCutStore.saveSnapshot(afterCut, afterCutUsers, afterCutLoans));
+    filesystem::copy_file(oldLogPath, logPath, filesystem::copy_options::overwrite_existing);
+    filesystem::remove(oldLogPath);
+    afterCutUsers.registerUser(User(5, "Erin")); // Logged with the new generation
+    BookInventory recovered;
+    UserService recoveredUsers;
+    LoanService recoveredLoans(recovered, recoveredUsers);
+    LibraryStore recoveredStore(snapshotPath, logPath);
+    assert(recoveredStore.open(recovered, recoveredUsers, recoveredLoans));
+    assert(recovered.getBookInfo(101).getTotalQuantity() == 5);
+    assert(recovered.getBookInfo(101).getTotalBorrowed() == 2);
+    assert(recoveredLoans.listLoansForUser(1).size() == 1 && recoveredUsers.userExist(5));
+
+    // A damaged last record is cut off; a damaged record before it refuses the whole log
+    {
+        fstream log(logPath, ios::binary | ios::in | ios::out);
+        log.seekp(-1, ios::end);
+        log.put('\x7f');
+    }
+    BookInventory tornTail;
+    UserService tornTailUsers;
+    LoanService tornTailLoans(tornTail, tornTailUsers);
+    LibraryStore tornTailStore(snapshotPath, logPath);
+    assert(tornTailStore.open(tornTail, tornTailUsers, tornTailLoans));
+    assert(!tornTailUsers.userExist(5) && tornTailUsers.userExist(4));
+    {
+        fstream log(logPath, ios::binary | ios::in | ios::out);
+        log.seekp(12); // The record type of the first record
+        log.put('\x7f');
+    }
+    BookInventory damaged;
+    UserService damagedUsers;
+    LoanService damagedLoans(damaged, damagedUsers);
+    LibraryStore damagedStore(snapshotPath, logPath);
+    assert(!damagedStore.open(damaged, damagedUsers, damagedLoans));
+    assert(!damagedStore.saveSnapshot(damaged, damagedUsers, damagedLoans));
+
+    // A corrupted snapshot loads nothing and is never overwritten
+    {
+        fstream snapshot(snapshotPath, ios::binary | ios::in | ios::out);
+        snapshot.seekp(-1, ios::end);
+        snapshot.put('\x7f');
+    }
+    const auto snapshotSize = filesystem::file_size(snapshotPath);
+    BookInventory corrupted;
+    UserService corruptedUsers;
+    LoanService corruptedLoans(corrupted, corruptedUsers);
+    LibraryStore corruptedStore(snapshotPath, logPath);
+    assert(!corruptedStore.open(corrupted, corruptedUsers, corruptedLoans));
+    assert(corrupted.getInventory().empty() && corruptedUsers.getUsers(SortOption::ID).empty());
+    assert(!corruptedStore.saveSnapshot(corrupted, corruptedUsers, corruptedLoans));
+    assert(filesystem::file_size(snapshotPath) == snapshotSize && filesystem::file_size(logPath) > 0);
+
+    filesystem::remove(snapshotPath);
+    filesystem::remove(logPath);
+    cout << "Passed: Persistence" << endl;
+}
+
 void testAdminFunctions() {
     cout << "Test: Admin Functions" << endl;
     BookInventory inventory;
@@ -687,12 +2006,286 @@ void testAdminFunctions() {
     cout << "Passed: Admin Functions" << endl;
 }
 
-int main() {
+void testTitlePool() {
+    cout << "Test: Title Pool" << endl;
+    TitlePool pool;
+    Book first = pool.makeBook(1, "Dune");
+    Book second = pool.makeBook(2, "Dune");
+    assert(first.getSharedName() == second.getSharedName() && pool.size() == 1);
+
+    Book moved = move(first);
+    assert(moved.getName() == "Dune" && moved.getId() == 1);
+    assert(Book().getName().empty());
+
+    {
+        Book temporary = pool.makeBook(3, "Emma");
+    }
+    pool.releaseUnused();
+    assert(pool.size() == 1);
+    cout << "Passed: Title Pool" << endl;
+}
+
+
+//////////////////////////
+//   Microbenchmark     //
+//////////////////////////
+
+
+// The record layout this file used before: copy-only, name returned by value
+class LegacyBook {
+private:
+    int id {};
+    string name {};
+
+public:
+    LegacyBook(int id, string name) : id(id), name(name) {}
+    LegacyBook(const LegacyBook& other) : id(other.id), name(other.name) {}
+    LegacyBook& operator=(const LegacyBook& other) = default;
+
+    int getId() const {
+        return id;
+    }
+
+    string getName() const {
+        return name;
+    }
+};
+
+template <class Work>
+double timeIt(Work work) {
+    auto start = chrono::steady_clock::now();
+    work();
+    return chrono::duration<double, milli>(chrono::steady_clock::now() - start).count();
+}
+
+// Compares sorting, prefix search and title memory for the old and new records
+void runBenchmark(size_t bookCount = 200000, size_t distinctTitles = 20000, size_t queries = 1000) {
+    mt19937 random(42);
+    vector<string> titles;
+    for (size_t i = 0; i < distinctTitles; ++i) {
+        titles.push_back("Collected Works of Author " + to_string(random() % 1000000) + ", Volume " + to_string(i));
+    }
+    vector<string> prefixes;
+    for (size_t i = 0; i < queries; ++i) {
+        prefixes.push_back(titles[random() % titles.size()].substr(0, 30));
+    }
+
+    vector<LegacyBook> legacyBooks;
+    vector<Book> books;
+    TitlePool pool;
+    vector<Book> pooledBooks;
+    for (size_t i = 0; i < bookCount; ++i) {
+        const string& title = titles[i % titles.size()];
+        legacyBooks.emplace_back(static_cast<int>(i), title);
+        books.emplace_back(static_cast<int>(i), title);
+        pooledBooks.push_back(pool.makeBook(static_cast<int>(i), title));
+    }
+
+    double legacySort = timeIt([&] {
+        sort(legacyBooks.begin(), legacyBooks.end(), [](const LegacyBook& a, const LegacyBook& b) {
+            return a.getName() < b.getName();
+        });
+    });
+    double newSort = timeIt([&] {
+        sort(books.begin(), books.end(), [](const Book& a, const Book& b) {
+            return a.getName() < b.getName();
+        });
+    });
+
+    // The old search: scan everything, build a substring per book, copy each match
+    unordered_map<int, LegacyBook> legacyInventory;
+    for (const LegacyBook& book : legacyBooks) {
+        legacyInventory.emplace(book.getId(), book);
+    }
+    // The scan is slow, so it only runs a sample of the queries
+    const size_t legacyQueries = min<size_t>(queries, 20);
+    size_t legacyMatches = 0, newMatches = 0, sampleMatches = 0;
+    double legacySearch = timeIt([&] {
+        for (size_t q = 0; q < legacyQueries; ++q) {
+            const string& prefix = prefixes[q];
+            vector<LegacyBook> res;
+            for (const auto& item : legacyInventory) {
+                const string bookName = item.second.getName();
+                if (bookName.size() >= prefix.size() && bookName.substr(0, prefix.size()) == prefix) {
+                    res.push_back(item.second);
+                }
+            }
+            legacyMatches += res.size();
+        }
+    });
+    BookInventory inventory;
+    inventory.reserve(bookCount);
+    for (const Book& book : pooledBooks) {
+        inventory.addBook(book, 1);
+    }
+    double newSearch = timeIt([&] {
+        for (const string& prefix : prefixes) {
+            newMatches += inventory.findByPrefix(prefix).size();
+        }
+    });
+    for (size_t q = 0; q < legacyQueries; ++q) {
+        sampleMatches += inventory.findByPrefix(prefixes[q]).size();
+    }
+    assert(legacyMatches == sampleMatches);
+
+    auto titleBytes = [](const string& title) {
+        return sizeof(string) + (title.size() > 15 ? title.capacity() + 1 : 0);
+    };
+    size_t legacyBytes = 0, pooledBytes = 0;
+    for (const LegacyBook& book : legacyBooks) {
+        legacyBytes += sizeof(int) + titleBytes(book.getName());
+    }
+    for (const string& title : titles) {
+        pooledBytes += titleBytes(title) + 2 * sizeof(void*); // Title plus its shared control block
+    }
+    pooledBytes += bookCount * sizeof(Book);
+
+    cout << fixed << setprecision(1);
+    cout << "Books: " << bookCount << ", distinct titles: " << distinctTitles << ", prefix queries: " << queries << '\n';
+    cout << left << setw(28) << "" << setw(14) << "Before" << "After\n";
+    cout << setw(28) << "Sort by name (ms)" << setw(14) << legacySort << newSort << '\n';
+    cout << setprecision(3);
+    cout << setw(28) << "Prefix search (ms/query)" << setw(14) << legacySearch / legacyQueries
+        << newSearch / queries << '\n';
+    cout << setprecision(1);
+    cout << setw(28) << "Book records + titles (KB)" << setw(14) << legacyBytes / 1024.0 << pooledBytes / 1024.0 << '\n';
+}
+
+// Times single operations and reports their throughput and latency percentiles
+class LatencyRecorder {
+private:
+    string name;
+    vector<double> samples; // Nanoseconds
+
+public:
+    explicit LatencyRecorder(string name) : name(move(name)) {}
+
+    template <class Work>
+    void measure(Work work) {
+        auto start = chrono::steady_clock::now();
+        work();
+        samples.push_back(chrono::duration<double, nano>(chrono::steady_clock::now() - start).count());
+    }
+
+    // Same columns as the AskMe and hospital benchmarks, so their output can be compared
+    static void printHeader(ostream& out) {
+        out << left << setw(28) << "Operation" << right << setw(10) << "Count" << setw(14) << "Ops/sec"
+            << setw(10) << "p50 us" << setw(10) << "p90 us" << setw(10) << "p99 us" << setw(10) << "Max us" << '\n';
+    }
+
+    void print(ostream& out) const {
+        if (samples.empty()) {
+            return;
+        }
+        vector<double> sorted = samples;
+        sort(sorted.begin(), sorted.end());
+        double totalNs = accumulate(sorted.begin(), sorted.end(), 0.0);
+        auto at = [&](double fraction) {
+            return sorted[min(sorted.size() - 1, static_cast<size_t>(fraction * sorted.size()))] / 1000.0;
+        };
+        out << left << setw(28) << name << right << setw(10) << sorted.size()
+            << fixed << setprecision(0) << setw(14) << sorted.size() / (totalNs / 1e9)
+            << setprecision(2) << setw(10) << at(0.50) << setw(10) << at(0.90) << setw(10) << at(0.99)
+            << setw(10) << sorted.back() / 1000.0 << '\n';
+        out.unsetf(ios::floatfield);
+    }
+};
+
+// Times the hot library operations one call at a time on a synthetic dataset
+// The same seed always produces the same dataset and the same operations
+void runOperationBenchmark(size_t bookCount, size_t userCount, size_t loanCount, size_t queries = 10000) {
+    mt19937 random(42);
+    TitlePool pool;
+    vector<string> titles;
+    for (size_t i = 0; i < bookCount / 10 + 1; ++i) {
+        titles.push_back("Collected Works of Author " + to_string(random() % 1000000) + ", Volume " + to_string(i));
+    }
+
+    BookInventory inventory;
+    BookService bookService(inventory);
+    UserService userService;
+    LoanService loanService(inventory, userService);
+    inventory.reserve(bookCount);
+
+    // The borrow/return paths print a line per call; time them without a terminal attached
+    streambuf* console = cout.rdbuf(nullptr);
+
+    LatencyRecorder addBook("addBook"), registerUser("registerUser"), search("searchBooksByPrefix"),
+        borrow("borrowBook"), giveBack("returnBook");
+    for (size_t i = 0; i < bookCount; ++i) {
+        Book book = pool.makeBook(static_cast<int>(i), titles[i % titles.size()]);
+        addBook.measure([&] { bookService.addBook(book, 2); });
+    }
+    for (size_t i = 0; i < userCount; ++i) {
+        User user(static_cast<int>(i), "User " + to_string(i));
+        registerUser.measure([&] { userService.registerUser(user); });
+    }
+    size_t matches = 0;
+    for (size_t q = 0; q < queries; ++q) {
+        string prefix = titles[random() % titles.size()].substr(0, 28 + random() % 6);
+        search.measure([&] { matches += bookService.searchBooksByPrefix(prefix, 10).size(); });
+    }
+    vector<LoanService::LoanRequest> loans;
+    for (size_t i = 0; i < loanCount && bookCount > 0 && userCount > 0; ++i) {
+        loans.push_back({static_cast<int>(random() % bookCount), static_cast<int>(random() % userCount)});
+    }
+    for (const auto& loan : loans) {
+        borrow.measure([&] { loanService.borrowBook(loan.bookId, loan.userId); });
+    }
+    shuffle(loans.begin(), loans.end(), random);
+    for (const auto& loan : loans) {
+        giveBack.measure([&] { loanService.returnBook(loan.bookId, loan.userId); });
+    }
+
+    cout.rdbuf(console);
+    cout.clear();
+
+    cout << "\nBooks: " << bookCount << ", users: " << userCount << ", loans: " << loanCount
+        << ", prefix queries: " << queries << " (" << matches << " matches)\n";
+    LatencyRecorder::printHeader(cout);
+    for (const LatencyRecorder* recorder : {&addBook, &registerUser, &search, &borrow, &giveBack}) {
+        recorder->print(cout);
+    }
+}
+
+// Usage: LibrarySystem [--benchmark [books] [users] [loans]]
+//   (no arguments)  Run the black-box tests
+//   --benchmark     Compare sort/search/memory cost of the record layouts, then
+//                   time each hot operation (defaults: 200000 books, 50000 users, 100000 loans)
+// Reads a non-negative count from the command line; fallback if it is missing or not a number
+size_t countArgument(int argc, char* argv[], int index, size_t fallback) {
+    if (index >= argc) {
+        return fallback;
+    }
+    string_view argument = argv[index];
+    size_t value = 0;
+    auto [end, error] = from_chars(argument.data(), argument.data() + argument.size(), value);
+    return error == errc() && end == argument.data() + argument.size() ? value : fallback;
+}
+
+int main(int argc, char* argv[]) {
+    if (argc > 1 && string(argv[1]) == "--benchmark") {
+        size_t books = countArgument(argc, argv, 2, 200000);
+        size_t users = countArgument(argc, argv, 3, 50000);
+        size_t loans = countArgument(argc, argv, 4, 100000);
+        runBenchmark(books, min<size_t>(books, 20000));
+        runOperationBenchmark(books, users, loans);
+        return 0;
+    }
+
     testAddBook();
     testListBooks();
     testSearchBooksByPrefix();
+    testSearchBooksByPrefixPaging();
+    testSortedViews();
     testRegisterUser();
+    testUserLookup();
     testBorrowAndReturnBook();
+    testLoanLedger();
+    testFindByName();
+    testBatchOperations();
+    testPersistence();
+    testTitlePool();
     testAdminFunctions();
     
     cout << "\nAll black-box tests passed successfully." << endl;